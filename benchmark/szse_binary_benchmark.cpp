@@ -0,0 +1,445 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    基准测试，按接近实盘的比例合成 300192/300191/300111/309011 报文语料，
+//            分别测量 Structure、GetField 及逐字段访问在 immutable_ 与 mutable_ 下的耗时，
+//            输出 ns/msg、GB/s 及 cycles/byte（非 x86 平台无 cycles/byte）
+//            编译：g++ -std=c++11 -O3 -march=native -pthread -I.. szse_binary_benchmark.cpp
+//            运行：./a.out [报文条数，默认 1000000] [重复次数，默认 5]
+//            各项取重复中的最好成绩；语料由固定种子生成，同一机器上结果可复现
+
+#include "szse_binary_columnar.hpp"
+#include "szse_binary_dispatch.hpp"
+#include "szse_binary_filter.hpp"
+#include "szse_binary_md_field.hpp"
+#include "szse_binary_packet.hpp"
+#include "szse_binary_probe.hpp"
+#include "szse_binary_synthetic.hpp"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+using namespace cn::szse::binary;
+
+// 防止被测代码被优化掉
+static volatile uint64_t g_sink = 0;
+
+// 合成的报文语料，Stream 为连续的完整报文
+struct Corpus
+{
+    std::vector<char> Stream;
+    size_t Count;
+};
+
+// 逐字段访问，immutable_ 与 mutable_ 共用
+template <typename TyField, typename Fn>
+inline uint64_t sum_array(const immutable_::FieldArray<TyField>& array, Fn fn)
+{
+    uint64_t sum = 0;
+    for (typename immutable_::FieldArray<TyField>::const_iterator it = array.begin();
+         it != array.end(); ++it)
+    {
+        sum += fn(*it);
+    }
+    return sum;
+}
+template <typename TyField, size_t InlineCount, typename Fn>
+inline uint64_t sum_array(const mutable_::FieldArray<TyField, InlineCount>& array, Fn fn)
+{
+    uint64_t sum = 0;
+    for (size_t idx = 0; idx < array.count(); ++idx)
+    {
+        sum += fn(array[idx]);
+    }
+    return sum;
+}
+struct touch_order_qty
+{
+    template <typename Ty>
+    uint64_t operator()(const Ty& entry) const { return (uint64_t)entry.Qty.raw_value(); }
+};
+struct touch_security_entry
+{
+    template <typename Ty>
+    uint64_t operator()(const Ty& entry) const
+    {
+        return (uint64_t)entry.MDEntryType.c_str()[0] + entry.MDEntryPx.get_value()
+            + entry.MDEntrySize.raw_value() + entry.MDPriceLevel.get_value()
+            + entry.NumberOfOrders.get_value()
+            + sum_array(entry.OrderQtyArray, touch_order_qty());
+    }
+};
+struct touch_index_entry
+{
+    template <typename Ty>
+    uint64_t operator()(const Ty& entry) const
+    {
+        return (uint64_t)entry.MDEntryType.c_str()[0] + entry.MDEntryPx.get_value();
+    }
+};
+template <is_mutable b>
+inline uint64_t touch(const OrderSnapshot_300192<b>& f)
+{
+    return (uint64_t)f.ChannelNo.get_value() + f.ApplSeqNum.get_value() + f.SecurityID.c_str()[5]
+        + f.Price.raw_value() + f.OrderQty.raw_value() + f.Side.c_str()[0]
+        + f.OrderTime.get_value() + f.OrdType.c_str()[0];
+}
+template <is_mutable b>
+inline uint64_t touch(const TransactionSnapshot_300191<b>& f)
+{
+    return (uint64_t)f.ChannelNo.get_value() + f.ApplSeqNum.get_value() + f.BidApplSeqNum.get_value()
+        + f.OfferApplSeqNum.get_value() + f.SecurityID.c_str()[5] + f.LastPx.raw_value()
+        + f.LastQty.raw_value() + f.ExecType.c_str()[0] + f.TransactTime.get_value();
+}
+template <is_mutable b>
+inline uint64_t touch_snapshot_base(const MarketSnapshotBase<b>& f)
+{
+    return (uint64_t)f.OrigTime.get_value() + f.ChannelNo.get_value() + f.SecurityID.c_str()[5]
+        + f.TradingPhaseCode.c_str()[0] + f.PrevClosePx.raw_value() + f.NumTrades.get_value()
+        + f.TotalVolumeTrade.raw_value() + f.TotalValueTrade.raw_value();
+}
+template <is_mutable b>
+inline uint64_t touch(const MarketSnapshot_300111<b>& f)
+{
+    return touch_snapshot_base(f) + sum_array(f.SecurityEntryArray, touch_security_entry());
+}
+template <is_mutable b>
+inline uint64_t touch(const MarketSnapshot_309011<b>& f)
+{
+    return touch_snapshot_base(f) + sum_array(f.IndexEntryArray, touch_index_entry());
+}
+
+// 各项测试：输入语料，返回校验值
+
+// 仅 Structure，CheckSumPolicy 决定是否校验
+template <typename CheckSumPolicy>
+struct StructureBench
+{
+    uint64_t operator()(const Corpus& corpus) const
+    {
+        immutable_::BasicPacket<CheckSumPolicy> packet;
+        const char* addr = corpus.Stream.data();
+        size_t remain = corpus.Stream.size();
+        uint64_t sum = 0;
+        while (remain > 0)
+        {
+            size_t mem_size = remain;
+            if (!packet.Structure(addr, &mem_size))
+            {
+                abort();
+            }
+            sum += packet.GetHeader()->MsgType.get_value();
+            addr += mem_size;
+            remain -= mem_size;
+        }
+        return sum;
+    }
+};
+
+// FrameBatch 成批结构化，校验和
+struct FrameBatchBench
+{
+    uint64_t operator()(const Corpus& corpus) const
+    {
+        PacketRef refs[256];
+        const char* addr = corpus.Stream.data();
+        size_t remain = corpus.Stream.size();
+        uint64_t sum = 0;
+        while (remain > 0)
+        {
+            size_t mem_size = remain;
+            size_t count = sizeof(refs) / sizeof(refs[0]);
+            if (!FrameBatch(addr, &mem_size, refs, &count) || count == 0)
+            {
+                abort();
+            }
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                sum += refs[idx].BodyLength;
+            }
+            addr += remain - mem_size;
+            remain = mem_size;
+        }
+        return sum;
+    }
+};
+
+// Structure + GetField，kAccess 为 true 时再逐字段访问，kProbe 为 true 时开启探针
+// 不校验校验和，以便与 StructureBench 的差值即为解析及访问的开销
+template <is_mutable b, bool kAccess, bool kProbe = false>
+struct DecodeBench
+{
+    typedef typename std::conditional<b, mutable_::BasicPacket<CheckSumSkip, kProbe>,
+        immutable_::BasicPacket<CheckSumSkip, kProbe> >::type packet_type;
+
+    uint64_t operator()(const Corpus& corpus) const
+    {
+        packet_type packet;
+        OrderSnapshot_300192<b> order;
+        TransactionSnapshot_300191<b> trade;
+        MarketSnapshot_300111<b> snapshot;
+        MarketSnapshot_309011<b> index;
+        const char* addr = corpus.Stream.data();
+        size_t remain = corpus.Stream.size();
+        uint64_t sum = 0;
+        while (remain > 0)
+        {
+            size_t mem_size = remain;
+            if (!packet.Structure(addr, &mem_size))
+            {
+                abort();
+            }
+            addr += mem_size;
+            remain -= mem_size;
+            switch (packet.GetHeader()->MsgType.get_value())
+            {
+            case OrderSnapshot_300192<b>::kMsgType:
+                sum += decode(packet, &order);
+                break;
+            case TransactionSnapshot_300191<b>::kMsgType:
+                sum += decode(packet, &trade);
+                break;
+            case MarketSnapshot_300111<b>::kMsgType:
+                sum += decode(packet, &snapshot);
+                break;
+            case MarketSnapshot_309011<b>::kMsgType:
+                sum += decode(packet, &index);
+                break;
+            default:
+                break;
+            }
+        }
+        return sum;
+    }
+    template <typename FieldType>
+    static inline uint64_t decode(const packet_type& packet, FieldType* field)
+    {
+        if (!packet.GetField(field))
+        {
+            abort();
+        }
+        return kAccess ? touch(*field) : 1;
+    }
+};
+
+// FrameBatch + Dispatch，访问者逐字段访问
+struct DispatchBench
+{
+    struct Visitor
+    {
+        uint64_t sum;
+        bool operator()(const immutable_::OrderSnapshot_300192& f) { sum += touch(f); return true; }
+        bool operator()(const immutable_::TransactionSnapshot_300191& f) { sum += touch(f); return true; }
+        bool operator()(const immutable_::MarketSnapshot_300111& f) { sum += touch(f); return true; }
+        bool operator()(const immutable_::MarketSnapshot_309011& f) { sum += touch(f); return true; }
+    };
+    uint64_t operator()(const Corpus& corpus) const
+    {
+        Visitor visitor = { 0 };
+        PacketRef refs[256];
+        const char* addr = corpus.Stream.data();
+        size_t remain = corpus.Stream.size();
+        while (remain > 0)
+        {
+            size_t mem_size = remain;
+            size_t count = sizeof(refs) / sizeof(refs[0]);
+            if (!FrameBatch(addr, &mem_size, refs, &count) || count == 0)
+            {
+                abort();
+            }
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                Dispatch(refs[idx], visitor);
+            }
+            addr += remain - mem_size;
+            remain = mem_size;
+        }
+        return visitor.sum;
+    }
+};
+
+// FrameBatch + 订阅过滤 + Dispatch，只订阅语料中约 15% 的证券（2000 只中的 300 只）
+struct FilteredDispatchBench
+{
+    FilteredDispatchBench()
+    {
+        SyntheticGenerator generator;
+        size_t count = generator.SecurityCount();
+        for (size_t idx = 0; idx < count; idx += count / 300)
+        {
+            filter.AddSecurity(generator.SecurityAt(idx));
+        }
+    }
+    uint64_t operator()(const Corpus& corpus) const
+    {
+        DispatchBench::Visitor visitor = { 0 };
+        PacketRef refs[256];
+        const char* addr = corpus.Stream.data();
+        size_t remain = corpus.Stream.size();
+        while (remain > 0)
+        {
+            size_t mem_size = remain;
+            size_t count = sizeof(refs) / sizeof(refs[0]);
+            if (!FrameBatch(addr, &mem_size, refs, &count) || count == 0)
+            {
+                abort();
+            }
+            size_t kept = filter.Filter(refs, count);
+            for (size_t idx = 0; idx < kept; ++idx)
+            {
+                Dispatch(refs[idx], visitor);
+            }
+            addr += remain - mem_size;
+            remain = mem_size;
+        }
+        return visitor.sum;
+    }
+    SubscriptionFilter filter;
+};
+
+// FrameBatch + 逐笔委托与逐笔成交的列式解码，列在构造时按语料条数预先分配
+struct ColumnarBench
+{
+    explicit ColumnarBench(size_t count)
+        : security_index(count), channel_no(count), appl_seq_num(count), bid_seq_num(count),
+          offer_seq_num(count), price(count), qty(count), time(count), side(count), type(count)
+    {
+    }
+    uint64_t operator()(const Corpus& corpus) const
+    {
+        OrderColumns orders = { security_index.data(), channel_no.data(), appl_seq_num.data(),
+                                price.data(), qty.data(), side.data(), type.data(), time.data() };
+        TradeColumns trades = { security_index.data(), channel_no.data(), appl_seq_num.data(),
+                                bid_seq_num.data(), offer_seq_num.data(), price.data(),
+                                qty.data(), side.data(), time.data() };
+        ColumnarDecoder decoder;
+        PacketRef refs[256];
+        const char* addr = corpus.Stream.data();
+        size_t remain = corpus.Stream.size();
+        uint64_t rows = 0;
+        while (remain > 0)
+        {
+            size_t mem_size = remain;
+            size_t count = sizeof(refs) / sizeof(refs[0]);
+            if (!FrameBatch(addr, &mem_size, refs, &count) || count == 0)
+            {
+                abort();
+            }
+            rows += decoder.DecodeOrders(refs, count, orders);
+            rows += decoder.DecodeTrades(refs, count, trades);
+            addr += remain - mem_size;
+            remain = mem_size;
+        }
+        return rows + (uint64_t)price[0];
+    }
+    mutable std::vector<uint32_t> security_index;
+    mutable std::vector<uint16_t> channel_no;
+    mutable std::vector<int64_t> appl_seq_num, bid_seq_num, offer_seq_num, price, qty, time;
+    mutable std::vector<char> side, type;
+};
+
+template <typename Bench>
+void RunBench(const char* name, const Corpus& corpus, int repeat, Bench bench)
+{
+    double best_seconds = std::numeric_limits<double>::max();
+    uint64_t best_cycles = 0;
+    for (int round = 0; round < repeat; ++round)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        uint64_t start_cycles = ReadTSC();
+        g_sink = g_sink + bench(corpus);
+        uint64_t cycles = ReadTSC() - start_cycles;
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        if (seconds < best_seconds)
+        {
+            best_seconds = seconds;
+            best_cycles = cycles;
+        }
+    }
+    double bytes = (double)corpus.Stream.size();
+    printf("  %-36s %9.1f ns/msg %8.3f GB/s", name,
+           best_seconds * 1e9 / (double)corpus.Count, bytes / best_seconds / 1e9);
+    if (kHasTSC)
+    {
+        printf(" %7.2f cycles/B\n", (double)best_cycles / bytes);
+    }
+    else
+    {
+        printf("       - cycles/B\n");
+    }
+}
+
+void PrintCorpus(const char* name, const Corpus& corpus)
+{
+    printf("%s: %zu msgs, %.1f MB, %.1f B/msg\n", name, corpus.Count,
+           corpus.Stream.size() / 1048576.0,
+           corpus.Count ? (double)corpus.Stream.size() / corpus.Count : 0.0);
+}
+
+// 宏观：混合语料上的完整流程
+void RunMacro(const Corpus& corpus, int repeat)
+{
+    PrintCorpus("mixed corpus", corpus);
+    RunBench("immutable Structure (verify)", corpus, repeat, StructureBench<CheckSumVerify>());
+    RunBench("immutable Structure (skip)", corpus, repeat, StructureBench<CheckSumSkip>());
+    RunBench("FrameBatch (verify)", corpus, repeat, FrameBatchBench());
+    RunBench("immutable Structure+GetField", corpus, repeat, DecodeBench<false, false>());
+    RunBench("immutable Structure+GetField+access", corpus, repeat, DecodeBench<false, true>());
+    RunBench("immutable Structure+GetField (probe)", corpus, repeat,
+             DecodeBench<false, false, true>());
+    RunBench("mutable Structure+GetField", corpus, repeat, DecodeBench<true, false>());
+    RunBench("mutable Structure+GetField+access", corpus, repeat, DecodeBench<true, true>());
+    RunBench("FrameBatch+Dispatch+access", corpus, repeat, DispatchBench());
+    RunBench("FrameBatch+Filter+Dispatch+access", corpus, repeat, FilteredDispatchBench());
+    RunBench("FrameBatch+columnar order/trade", corpus, repeat, ColumnarBench(corpus.Count));
+}
+
+// 微观：单一消息类型的语料
+void RunMicro(const char* name, const SyntheticMix& mix, size_t count, int repeat)
+{
+    Corpus corpus;
+    corpus.Count = SyntheticGenerator(mix).Generate(count, &corpus.Stream);
+    PrintCorpus(name, corpus);
+    RunBench("immutable Structure (skip)", corpus, repeat, StructureBench<CheckSumSkip>());
+    RunBench("immutable GetField", corpus, repeat, DecodeBench<false, false>());
+    RunBench("immutable GetField+access", corpus, repeat, DecodeBench<false, true>());
+    RunBench("mutable GetField", corpus, repeat, DecodeBench<true, false>());
+    RunBench("mutable GetField+access", corpus, repeat, DecodeBench<true, true>());
+}
+
+int main(int argc, char* argv[])
+{
+    size_t count = argc > 1 ? (size_t)strtoull(argv[1], nullptr, 10) : 1000000;
+    int repeat = argc > 2 ? atoi(argv[2]) : 5;
+    if (count == 0 || repeat <= 0)
+    {
+        fprintf(stderr, "usage: %s [message count] [repeat]\n", argv[0]);
+        return 1;
+    }
+
+    Corpus corpus;
+    corpus.Count = SyntheticGenerator(kRealisticMix).Generate(count, &corpus.Stream);
+    RunMacro(corpus, repeat);
+    ProbeSnapshot probe;
+    ProbeRegistry::Instance().Snapshot(&probe);
+    printf("probe of immutable Structure+GetField (%s):\n%s", kHasTSC ? "cycles" : "ns",
+           probe.ToString().c_str());
+
+    static const SyntheticMix kOrderOnly = { 1, 0, 0, 0 };
+    static const SyntheticMix kTradeOnly = { 0, 1, 0, 0 };
+    static const SyntheticMix kSnapshotOnly = { 0, 0, 1, 0 };
+    static const SyntheticMix kIndexOnly = { 0, 0, 0, 1 };
+    RunMicro("300192 OrderSnapshot", kOrderOnly, count, repeat);
+    RunMicro("300191 TransactionSnapshot", kTradeOnly, count, repeat);
+    RunMicro("300111 MarketSnapshot", kSnapshotOnly, count / 10 + 1, repeat);
+    RunMicro("309011 IndexSnapshot", kIndexOnly, count, repeat);
+
+    printf("(sink %llu)\n", (unsigned long long)g_sink);
+    return 0;
+}
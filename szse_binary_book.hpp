@@ -0,0 +1,456 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    逐笔委托（300192）与逐笔成交（300191）重建的全深度订单簿
+//            价位按价格有序保存在连续数组中，委托按 ChannelNo 与 ApplSeqNum 建立开放寻址索引
+
+#ifndef __CN_SZSE_BINARY_BOOK_H__
+#define __CN_SZSE_BINARY_BOOK_H__
+
+#include "szse_binary_md_field.hpp"
+#include "szse_binary_symbol.hpp"
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+// 买卖方向
+static const int kBookBid = 0;
+static const int kBookAsk = 1;
+
+// 订单簿价位，Price 与 Qty 为报文中的原始整数（Price 放大 10^4，Qty 放大 10^2）
+struct BookLevel
+{
+    int64_t     Price;
+    int64_t     Qty;
+    uint32_t    OrderCount;
+};
+
+// 每次更新后发布的前 N 档
+template <size_t N>
+struct BookDepth
+{
+    char        SecurityID[8];      // 证券代码，右补空格
+    uint16_t    ChannelNo;
+    int64_t     ApplSeqNum;         // 最近一次更新的消息记录号
+    int64_t     UpdateTime;         // 最近一次更新的委托或成交时间
+    uint32_t    BidLevels;          // Bid 中的有效档数
+    uint32_t    AskLevels;
+    BookLevel   Bid[N];             // Bid[0] 为最优买价
+    BookLevel   Ask[N];             // Ask[0] 为最优卖价
+};
+
+// @Class:   OrderBook
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   单个证券的订单簿，每一方的价位保存在按价格排序的连续数组中，
+//           最优价位位于数组末尾，靠近最优价的增删只移动少量元素
+class OrderBook
+{
+public:
+    explicit OrderBook(const char* security_id)
+    {
+        memcpy(security_id_, security_id, sizeof(security_id_));
+        levels_[kBookBid].reserve(64);
+        levels_[kBookAsk].reserve(64);
+    }
+    inline const char* SecurityID() const { return security_id_; }
+    // 价位数
+    inline size_t Levels(int side) const { return levels_[side].size(); }
+    // 第 idx 档，0 为最优，调用方保证 idx < Levels(side)
+    inline const BookLevel& Level(int side, size_t idx) const
+    {
+        return levels_[side][levels_[side].size() - 1 - idx];
+    }
+    // 最优价，该方为空时返回 0
+    inline int64_t BestPrice(int side) const
+    {
+        return levels_[side].empty() ? 0 : levels_[side].back().Price;
+    }
+    // 在 price 价位增加一笔委托
+    void Add(int side, int64_t price, int64_t qty)
+    {
+        std::vector<BookLevel>& levels = levels_[side];
+        std::vector<BookLevel>::iterator it = find(side, price);
+        if (it != levels.end() && it->Price == price)
+        {
+            it->Qty += qty;
+            ++it->OrderCount;
+            return;
+        }
+        BookLevel level = { price, qty, 1 };
+        levels.insert(it, level);
+    }
+    // 从 price 价位减少 qty，order_done 表示该委托已全部成交或撤销
+    void Reduce(int side, int64_t price, int64_t qty, bool order_done)
+    {
+        std::vector<BookLevel>& levels = levels_[side];
+        std::vector<BookLevel>::iterator it = find(side, price);
+        if (it == levels.end() || it->Price != price)
+        {
+            return;
+        }
+        it->Qty -= qty;
+        if (order_done && it->OrderCount > 0)
+        {
+            --it->OrderCount;
+        }
+        if (it->OrderCount == 0 || it->Qty <= 0)
+        {
+            levels.erase(it);
+        }
+    }
+    template <size_t N>
+    void Depth(BookDepth<N>* depth) const
+    {
+        memcpy(depth->SecurityID, security_id_, sizeof(security_id_));
+        depth->BidLevels = (uint32_t)std::min(N, Levels(kBookBid));
+        depth->AskLevels = (uint32_t)std::min(N, Levels(kBookAsk));
+        for (uint32_t idx = 0; idx < depth->BidLevels; ++idx)
+        {
+            depth->Bid[idx] = Level(kBookBid, idx);
+        }
+        for (uint32_t idx = 0; idx < depth->AskLevels; ++idx)
+        {
+            depth->Ask[idx] = Level(kBookAsk, idx);
+        }
+    }
+private:
+    // 买方升序、卖方降序，返回第一个不比 price 更优先的位置（用于插入）
+    std::vector<BookLevel>::iterator find(int side, int64_t price)
+    {
+        std::vector<BookLevel>& levels = levels_[side];
+        if (side == kBookBid)
+        {
+            return std::lower_bound(levels.begin(), levels.end(), price,
+                [](const BookLevel& level, int64_t p) { return level.Price < p; });
+        }
+        return std::lower_bound(levels.begin(), levels.end(), price,
+            [](const BookLevel& level, int64_t p) { return level.Price > p; });
+    }
+
+    char security_id_[8];
+    std::vector<BookLevel> levels_[2];
+};
+
+// @Class:   OrderIndex
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   在簿委托索引，键为 (ChannelNo << 48) | ApplSeqNum，
+//           开放寻址、线性探测，删除时后移填补空位，不使用墓碑
+class OrderIndex
+{
+public:
+    struct Entry
+    {
+        uint64_t    key;            // 0 表示空位
+        int64_t     price;          // 0 表示尚未确定价格的市价委托，不在价位中
+        int64_t     qty;            // 剩余数量
+        uint32_t    book;           // 所属订单簿下标
+        int32_t     side;
+    };
+
+    explicit OrderIndex(size_t capacity = 1 << 20) : size_(0)
+    {
+        size_t slots = 16;
+        while (slots < capacity * 2) { slots <<= 1; }
+        entries_.assign(slots, Entry());
+    }
+    static inline uint64_t Key(uint16_t channel_no, int64_t appl_seq_num)
+    {
+        return ((uint64_t)channel_no << 48) | ((uint64_t)appl_seq_num & 0xFFFFFFFFFFFFull);
+    }
+    inline size_t Size() const { return size_; }
+    Entry* Find(uint64_t key)
+    {
+        size_t mask = entries_.size() - 1;
+        for (size_t pos = slot_of(key); ; pos = (pos + 1) & mask)
+        {
+            Entry& entry = entries_[pos];
+            if (entry.key == key)
+            {
+                return &entry;
+            }
+            if (entry.key == 0)
+            {
+                return nullptr;
+            }
+        }
+    }
+    // 插入新委托，键已存在时覆盖
+    Entry* Insert(uint64_t key)
+    {
+        if ((size_ + 1) * 2 > entries_.size())
+        {
+            rehash(entries_.size() * 2);
+        }
+        size_t mask = entries_.size() - 1;
+        size_t pos = slot_of(key);
+        while (entries_[pos].key != 0 && entries_[pos].key != key)
+        {
+            pos = (pos + 1) & mask;
+        }
+        if (entries_[pos].key == 0)
+        {
+            ++size_;
+        }
+        entries_[pos].key = key;
+        return &entries_[pos];
+    }
+    void Erase(Entry* entry)
+    {
+        size_t mask = entries_.size() - 1;
+        size_t hole = entry - &entries_[0];
+        entries_[hole].key = 0;
+        --size_;
+        // 将后续探测链上的元素前移，保证查找不会提前遇到空位
+        for (size_t pos = (hole + 1) & mask; entries_[pos].key != 0; pos = (pos + 1) & mask)
+        {
+            size_t home = slot_of(entries_[pos].key);
+            if (((pos - home) & mask) >= ((pos - hole) & mask))
+            {
+                entries_[hole] = entries_[pos];
+                entries_[pos].key = 0;
+                hole = pos;
+            }
+        }
+    }
+private:
+    inline size_t slot_of(uint64_t key) const
+    {
+        return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (entries_.size() - 1);
+    }
+    void rehash(size_t slots)
+    {
+        std::vector<Entry> old(slots, Entry());
+        old.swap(entries_);
+        size_ = 0;
+        for (auto &entry : old)
+        {
+            if (entry.key != 0)
+            {
+                *Insert(entry.key) = entry;
+            }
+        }
+    }
+
+    std::vector<Entry> entries_;
+    size_t size_;
+};
+
+// 不处理更新的监听者
+struct NullBookListener
+{
+    template <size_t N>
+    void operator()(const OrderBook&, const BookDepth<N>&) {}
+};
+
+// @Class:   BasicOrderBookEngine
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   按 ApplSeqNum 顺序应用逐笔委托与逐笔成交，维护各证券的全深度订单簿，
+//           每次更新后以前 Depth 档调用 listener(const OrderBook&, const BookDepth<Depth>&)
+//           委托类别：
+//               2 限价    按委托价格入簿
+//               1 市价    以到达时的对手方最优价入簿，对手方为空时暂不入簿
+//               U 本方最优 以到达时的本方最优价入簿，本方为空时暂不入簿
+//           未入簿的委托仍可被成交或撤单消息引用
+//           同一频道中重复或回退的 ApplSeqNum 被忽略，跳号计入 GapCount 后照常应用
+//           可直接作为 Dispatch 的访问者
+template <typename Listener = NullBookListener, size_t Depth = 10>
+class BasicOrderBookEngine
+{
+public:
+    explicit BasicOrderBookEngine(const Listener& listener = Listener(),
+                                  size_t order_capacity = 1 << 20,
+                                  size_t security_capacity = 1 << 16)
+        : listener_(listener), orders_(order_capacity), securities_(security_capacity),
+          gap_count_(0),
+          unknown_count_(0), last_channel_(0), last_seq_(nullptr)
+    {
+    }
+
+    void operator()(const immutable_::OrderSnapshot_300192& order) { OnOrder(order); }
+    void operator()(const immutable_::TransactionSnapshot_300191& trade) { OnTransaction(trade); }
+
+    // 应用逐笔委托，重复的消息返回 false
+    bool OnOrder(const immutable_::OrderSnapshot_300192& order)
+    {
+        uint16_t channel_no = order.ChannelNo.get_value();
+        int64_t appl_seq_num = order.ApplSeqNum.get_value();
+        if (!accept(channel_no, appl_seq_num))
+        {
+            return false;
+        }
+        int side = side_of(order.Side.at(0));
+        if (side < 0)
+        {
+            return true;
+        }
+        uint32_t book_idx = book_of(order.SecurityID.c_str());
+        if (book_idx == kInvalidSecurityIndex)
+        {
+            return true;
+        }
+        OrderBook& book = *books_[book_idx];
+        int64_t price = 0;
+        switch (order.OrdType.at(0))
+        {
+        case '1':
+            price = book.BestPrice(1 - side);
+            break;
+        case 'U':
+            price = book.BestPrice(side);
+            break;
+        default:
+            price = order.Price.raw_value();
+            break;
+        }
+        int64_t qty = order.OrderQty.raw_value();
+        OrderIndex::Entry* entry = orders_.Insert(OrderIndex::Key(channel_no, appl_seq_num));
+        entry->price = price;
+        entry->qty = qty;
+        entry->book = book_idx;
+        entry->side = side;
+        if (price != 0)
+        {
+            book.Add(side, price, qty);
+        }
+        publish(book, channel_no, appl_seq_num, order.OrderTime.get_value());
+        return true;
+    }
+    // 应用逐笔成交或撤单，重复的消息返回 false
+    bool OnTransaction(const immutable_::TransactionSnapshot_300191& trade)
+    {
+        uint16_t channel_no = trade.ChannelNo.get_value();
+        int64_t appl_seq_num = trade.ApplSeqNum.get_value();
+        if (!accept(channel_no, appl_seq_num))
+        {
+            return false;
+        }
+        int64_t qty = trade.LastQty.raw_value();
+        OrderBook* book = nullptr;
+        book = reduce(channel_no, trade.BidApplSeqNum.get_value(), qty, book);
+        book = reduce(channel_no, trade.OfferApplSeqNum.get_value(), qty, book);
+        if (book)
+        {
+            publish(*book, channel_no, appl_seq_num, trade.TransactTime.get_value());
+        }
+        return true;
+    }
+
+    // 证券代码（8 字节，右补空格）对应的订单簿，不存在时返回 nullptr
+    const OrderBook* GetBook(const char* security_id) const
+    {
+        uint32_t book_idx = securities_.Find(security_id);
+        return book_idx == kInvalidSecurityIndex ? nullptr : books_[book_idx].get();
+    }
+    inline size_t BookCount() const { return books_.size(); }
+    inline size_t OrderCount() const { return orders_.Size(); }
+    // 跳号次数
+    inline uint64_t GapCount() const { return gap_count_; }
+    // 成交或撤单引用了不在簿中的委托的次数
+    inline uint64_t UnknownCount() const { return unknown_count_; }
+    Listener& GetListener() { return listener_; }
+private:
+    static inline int side_of(char side)
+    {
+        return side == '1' ? kBookBid : side == '2' ? kBookAsk : -1;
+    }
+    // 证券下标即订单簿下标，证券表已满时返回 kInvalidSecurityIndex
+    uint32_t book_of(const char* security_id)
+    {
+        uint32_t book_idx = securities_.Intern(security_id);
+        if (book_idx == books_.size())
+        {
+            books_.emplace_back(new OrderBook(security_id));
+        }
+        return book_idx;
+    }
+    // 同一频道的 ApplSeqNum 须递增
+    bool accept(uint16_t channel_no, int64_t appl_seq_num)
+    {
+        if (last_seq_ == nullptr || channel_no != last_channel_)
+        {
+            last_seq_ = &channel_seq_[channel_no];
+            last_channel_ = channel_no;
+        }
+        if (appl_seq_num <= *last_seq_)
+        {
+            return false;
+        }
+        if (*last_seq_ != 0 && appl_seq_num != *last_seq_ + 1)
+        {
+            ++gap_count_;
+        }
+        *last_seq_ = appl_seq_num;
+        return true;
+    }
+    // 委托减少 qty，返回其所属订单簿
+    OrderBook* reduce(uint16_t channel_no, int64_t order_seq, int64_t qty, OrderBook* book)
+    {
+        if (order_seq == 0)
+        {
+            return book;
+        }
+        OrderIndex::Entry* entry = orders_.Find(OrderIndex::Key(channel_no, order_seq));
+        if (entry == nullptr)
+        {
+            ++unknown_count_;
+            return book;
+        }
+        OrderBook* order_book = books_[entry->book].get();
+        int64_t done_qty = std::min(qty, entry->qty);
+        bool order_done = done_qty == entry->qty;
+        if (entry->price != 0)
+        {
+            order_book->Reduce(entry->side, entry->price, done_qty, order_done);
+        }
+        if (order_done)
+        {
+            orders_.Erase(entry);
+        }
+        else
+        {
+            entry->qty -= done_qty;
+        }
+        return order_book;
+    }
+    void publish(const OrderBook& book, uint16_t channel_no,
+                 int64_t appl_seq_num, int64_t update_time)
+    {
+        depth_.ChannelNo = channel_no;
+        depth_.ApplSeqNum = appl_seq_num;
+        depth_.UpdateTime = update_time;
+        book.Depth(&depth_);
+        listener_(book, static_cast<const BookDepth<Depth>&>(depth_));
+    }
+
+    Listener listener_;
+    OrderIndex orders_;
+    std::vector<std::unique_ptr<OrderBook> > books_;
+    SecurityTable securities_;
+    std::unordered_map<uint16_t, int64_t> channel_seq_;
+    BookDepth<Depth> depth_;
+    uint64_t gap_count_;
+    uint64_t unknown_count_;
+    uint16_t last_channel_;
+    int64_t* last_seq_;                 // channel_seq_ 中最近使用的频道
+};
+typedef BasicOrderBookEngine<> OrderBookEngine;
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_BOOK_H__
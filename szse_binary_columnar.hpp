@@ -0,0 +1,221 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    逐笔委托与逐笔成交的批量列式解码，用于研究与历史数据回补
+//            成批的报文直接按定长布局中的偏移逐列读取，写入调用方预先分配的列，
+//            不经过 GetField 与逐条的数据域对象
+
+#ifndef __CN_SZSE_BINARY_COLUMNAR_H__
+#define __CN_SZSE_BINARY_COLUMNAR_H__
+
+#include "szse_binary_md_field.hpp"
+#include "szse_binary_packet.hpp"
+#include "szse_binary_symbol.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+// 逐笔委托的列，与 TickStoreWriter 的 order 列相同；为 nullptr 的列不解码
+// 各列由调用方分配，长度不小于输入的报文数
+struct OrderColumns
+{
+    uint32_t*   SecurityIndex;
+    uint16_t*   ChannelNo;
+    int64_t*    ApplSeqNum;
+    int64_t*    Price;              // 放大 10^4
+    int64_t*    OrderQty;           // 放大 10^2
+    char*       Side;
+    char*       OrdType;
+    int64_t*    OrderTime;
+};
+
+// 逐笔成交的列，与 TickStoreWriter 的 trade 列相同；为 nullptr 的列不解码
+struct TradeColumns
+{
+    uint32_t*   SecurityIndex;
+    uint16_t*   ChannelNo;
+    int64_t*    ApplSeqNum;
+    int64_t*    BidApplSeqNum;
+    int64_t*    OfferApplSeqNum;
+    int64_t*    LastPx;             // 放大 10^4
+    int64_t*    LastQty;            // 放大 10^2
+    char*       ExecType;
+    int64_t*    TransactTime;
+};
+
+// 按列收集：第 i 个报文体 Offset 处的大端整数写入 out[i]
+// 每列一个无分支的循环，只有加载、字节交换与存储，编译器可展开或向量化
+template <typename IntTy, size_t Offset>
+inline void GatherBigEndian(const char* const* bodies, size_t count, IntTy* out)
+{
+    if (out == nullptr)
+    {
+        return;
+    }
+    for (size_t idx = 0; idx < count; ++idx)
+    {
+        out[idx] = LoadBigEndian<IntTy>(bodies[idx] + Offset);
+    }
+}
+// 按列收集单字节的字符串字段
+template <size_t Offset>
+inline void GatherChar(const char* const* bodies, size_t count, char* out)
+{
+    if (out == nullptr)
+    {
+        return;
+    }
+    for (size_t idx = 0; idx < count; ++idx)
+    {
+        out[idx] = bodies[idx][Offset];
+    }
+}
+// 按列收集证券下标，新出现的代码由 table 分配下标
+template <size_t Offset>
+inline void GatherSecurityIndex(const char* const* bodies, size_t count,
+                                SecurityTable& table, uint32_t* out)
+{
+    if (out == nullptr)
+    {
+        return;
+    }
+    for (size_t idx = 0; idx < count; ++idx)
+    {
+        out[idx] = table.Intern(SecurityKey(bodies[idx] + Offset));
+    }
+}
+
+// @Class:   ColumnarDecoder
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   每批先挑出消息类型相符且长度足够的报文体，再逐列收集，
+//           同一列的读取在一个循环中完成，各报文的字段地址由定长布局在编译期确定
+//           逐笔委托只解码 300192（OrdType 为其扩展字段）；
+//           逐笔成交解码 300191、300591、300791，所需字段均为公共字段
+//           证券下标由 SecurityTable::Intern 分配，与 TickStoreWriter 相同，
+//           因此须在 table 的写线程中调用
+class ColumnarDecoder
+{
+    static const size_t kChunkSize = 256;
+
+    typedef immutable_::OrderSnapshot_300192::layout_type order_layout;
+    typedef immutable_::TransactionSnapshot_300191::layout_type trade_layout;
+public:
+    explicit ColumnarDecoder(SecurityTable& table = DefaultSecurityTable())
+        : table_(table), skipped_(0) {}
+
+    // 解码 refs 中的逐笔委托，其余报文跳过；返回写入的行数，第 i 行写入各列的下标 i
+    size_t DecodeOrders(const PacketRef* refs, size_t ref_count, const OrderColumns& columns)
+    {
+        const char* bodies[kChunkSize];
+        size_t rows = 0;
+        for (size_t begin = 0; begin < ref_count; begin += kChunkSize)
+        {
+            size_t end = begin + kChunkSize < ref_count ? begin + kChunkSize : ref_count;
+            size_t count = select<is_order, order_layout::kSize>(refs + begin, end - begin,
+                                                                   bodies);
+            gather_orders(bodies, count, columns, rows);
+            rows += count;
+        }
+        return rows;
+    }
+    // 解码 refs 中的逐笔成交，其余报文跳过；返回写入的行数
+    size_t DecodeTrades(const PacketRef* refs, size_t ref_count, const TradeColumns& columns)
+    {
+        const char* bodies[kChunkSize];
+        size_t rows = 0;
+        for (size_t begin = 0; begin < ref_count; begin += kChunkSize)
+        {
+            size_t end = begin + kChunkSize < ref_count ? begin + kChunkSize : ref_count;
+            size_t count = select<is_trade, trade_layout::kSize>(refs + begin, end - begin,
+                                                                   bodies);
+            gather_trades(bodies, count, columns, rows);
+            rows += count;
+        }
+        return rows;
+    }
+
+    // 消息类型相符但报文体过短而跳过的报文数
+    inline uint64_t Skipped() const { return skipped_; }
+
+private:
+    static inline bool is_order(uint32_t msg_type)
+    {
+        return msg_type == immutable_::OrderSnapshot_300192::kMsgType;
+    }
+    static inline bool is_trade(uint32_t msg_type)
+    {
+        return msg_type == immutable_::TransactionSnapshot_300191::kMsgType
+            || msg_type == immutable_::TransactionSnapshot_300591::kMsgType
+            || msg_type == immutable_::TransactionSnapshot_300791::kMsgType;
+    }
+    // 无分支地挑出报文体：地址总是写入，满足条件时才前移，消息类型交错时不产生分支预测失败
+    // Predicate 为模板参数，编译期内联
+    template <bool (*Predicate)(uint32_t), size_t MinLength>
+    size_t select(const PacketRef* refs, size_t ref_count, const char** bodies)
+    {
+        size_t count = 0;
+        for (size_t idx = 0; idx < ref_count; ++idx)
+        {
+            bool matched = Predicate(refs[idx].MsgType);
+            bool valid = refs[idx].BodyLength >= MinLength;
+            bodies[count] = refs[idx].BodyAddr;
+            count += matched & valid;
+            skipped_ += matched & !valid;
+        }
+        return count;
+    }
+    // 列指针偏移到第 row 行后收集
+    template <typename Ty>
+    static inline Ty* at(Ty* column, size_t row)
+    {
+        return column ? column + row : nullptr;
+    }
+    void gather_orders(const char* const* bodies, size_t count, const OrderColumns& c,
+                       size_t row)
+    {
+        GatherSecurityIndex<order_layout::offset(3)>(bodies, count, table_,
+                                                     at(c.SecurityIndex, row));
+        GatherBigEndian<uint16_t, order_layout::offset(0)>(bodies, count, at(c.ChannelNo, row));
+        GatherBigEndian<int64_t, order_layout::offset(1)>(bodies, count, at(c.ApplSeqNum, row));
+        GatherBigEndian<int64_t, order_layout::offset(5)>(bodies, count, at(c.Price, row));
+        GatherBigEndian<int64_t, order_layout::offset(6)>(bodies, count, at(c.OrderQty, row));
+        GatherChar<order_layout::offset(7)>(bodies, count, at(c.Side, row));
+        GatherBigEndian<int64_t, order_layout::offset(8)>(bodies, count, at(c.OrderTime, row));
+        GatherChar<order_layout::offset(9)>(bodies, count, at(c.OrdType, row));
+    }
+    void gather_trades(const char* const* bodies, size_t count, const TradeColumns& c,
+                       size_t row)
+    {
+        GatherSecurityIndex<trade_layout::offset(5)>(bodies, count, table_,
+                                                     at(c.SecurityIndex, row));
+        GatherBigEndian<uint16_t, trade_layout::offset(0)>(bodies, count, at(c.ChannelNo, row));
+        GatherBigEndian<int64_t, trade_layout::offset(1)>(bodies, count, at(c.ApplSeqNum, row));
+        GatherBigEndian<int64_t, trade_layout::offset(3)>(bodies, count,
+                                                          at(c.BidApplSeqNum, row));
+        GatherBigEndian<int64_t, trade_layout::offset(4)>(bodies, count,
+                                                          at(c.OfferApplSeqNum, row));
+        GatherBigEndian<int64_t, trade_layout::offset(7)>(bodies, count, at(c.LastPx, row));
+        GatherBigEndian<int64_t, trade_layout::offset(8)>(bodies, count, at(c.LastQty, row));
+        GatherChar<trade_layout::offset(9)>(bodies, count, at(c.ExecType, row));
+        GatherBigEndian<int64_t, trade_layout::offset(10)>(bodies, count,
+                                                           at(c.TransactTime, row));
+    }
+
+    SecurityTable& table_;
+    uint64_t skipped_;
+};
+
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_COLUMNAR_H__
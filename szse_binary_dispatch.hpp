@@ -0,0 +1,287 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    按消息类型分发报文，由消息类型列表在编译期生成跳转表
+//            消息类型经完美哈希映射为跳转表下标，调用访问者时不经过虚函数
+
+#ifndef __CN_SZSE_BINARY_DISPATCH_H__
+#define __CN_SZSE_BINARY_DISPATCH_H__
+
+#include "szse_binary_md_field.hpp"
+#include "szse_binary_packet.hpp"
+
+#include <stdint.h>
+#include <type_traits>
+#include <utility>
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+// 消息类型列表
+template <typename ...Tys> struct MsgTypeList {};
+
+// 全部消息类型
+typedef MsgTypeList<
+    immutable_::Logon,
+    immutable_::Logout,
+    immutable_::Heartbeat,
+    immutable_::BusinessReject,
+    immutable_::ChannelHeartbeat,
+    immutable_::Announcement,
+    immutable_::ReTransmit,
+    immutable_::MarketStatus,
+    immutable_::SecurityStatus,
+    immutable_::MarketSnapshotStatistic,
+    immutable_::MarketSnapshot_300111,
+    immutable_::MarketSnapshot_300611,
+    immutable_::MarketSnapshot_306311,
+    immutable_::MarketSnapshot_309011,
+    immutable_::MarketSnapshot_309111,
+    immutable_::OrderSnapshot_300192,
+    immutable_::OrderSnapshot_300592,
+    immutable_::OrderSnapshot_300792,
+    immutable_::TransactionSnapshot_300191,
+    immutable_::TransactionSnapshot_300591,
+    immutable_::TransactionSnapshot_300791> AllMsgTypes;
+
+// 默认的热点消息类型，分发时先于跳转表逐个比较并标记为 likely
+typedef MsgTypeList<
+    immutable_::OrderSnapshot_300192,
+    immutable_::TransactionSnapshot_300191,
+    immutable_::MarketSnapshot_300111> HotMsgTypes;
+
+// 消息类型的完美哈希：乘法哈希取高 5 位，AllMsgTypes 中各类型互不冲突
+static const uint32_t kMsgTypeHashMul = 0x1a55b762;
+static const uint32_t kMsgTypeHashBits = 5;
+static const uint32_t kMsgTypeSlotCount = 1u << kMsgTypeHashBits;
+
+constexpr uint32_t MsgTypeSlot(uint32_t msg_type)
+{
+    return (uint32_t)(msg_type * kMsgTypeHashMul) >> (32 - kMsgTypeHashBits);
+}
+
+// 判断 Slot 是否已被 Tys 中的某个类型占用
+template <uint32_t Slot, typename ...Tys>
+struct msg_type_slot_used : std::false_type {};
+
+template <uint32_t Slot, typename Ty, typename ...Rest>
+struct msg_type_slot_used<Slot, Ty, Rest...>
+    : std::integral_constant<bool, MsgTypeSlot(Ty::kMsgType) == Slot
+        || msg_type_slot_used<Slot, Rest...>::value>
+{
+};
+
+// 判断消息类型列表的哈希是否无冲突
+template <typename List> struct msg_type_hash_perfect;
+
+template <>
+struct msg_type_hash_perfect<MsgTypeList<> > : std::true_type {};
+
+template <typename Ty, typename ...Rest>
+struct msg_type_hash_perfect<MsgTypeList<Ty, Rest...> >
+    : std::integral_constant<bool,
+        !msg_type_slot_used<MsgTypeSlot(Ty::kMsgType), Rest...>::value
+        && msg_type_hash_perfect<MsgTypeList<Rest...> >::value>
+{
+};
+
+static_assert(msg_type_hash_perfect<AllMsgTypes>::value,
+              "kMsgTypeHashMul is not a perfect hash of AllMsgTypes");
+
+// 判断访问者能否接收 FieldType
+template <typename Visitor, typename FieldType>
+struct is_field_visitor
+{
+private:
+    template <typename V>
+    static auto test(int) -> decltype(
+        std::declval<V&>()(std::declval<const FieldType&>()), std::true_type());
+    template <typename V>
+    static std::false_type test(...);
+public:
+    static const bool value = decltype(test<Visitor>(0))::value;
+};
+
+// 判断访问者是否提供了 Unknown(uint32_t msg_type, const char* body, size_t body_length)
+template <typename Visitor>
+struct has_unknown_visitor
+{
+private:
+    template <typename V>
+    static auto test(int) -> decltype(std::declval<V&>().Unknown(
+        uint32_t(), (const char*)nullptr, size_t()), std::true_type());
+    template <typename V>
+    static std::false_type test(...);
+public:
+    static const bool value = decltype(test<Visitor>(0))::value;
+};
+
+// 未知类型或访问者未处理的类型
+template <typename Visitor>
+inline typename std::enable_if<has_unknown_visitor<Visitor>::value, bool>::type
+visit_unknown(uint32_t msg_type, const char* body, size_t body_length,
+              Visitor& visitor)
+{
+    visitor.Unknown(msg_type, body, body_length);
+    return true;
+}
+template <typename Visitor>
+inline typename std::enable_if<!has_unknown_visitor<Visitor>::value, bool>::type
+visit_unknown(uint32_t, const char*, size_t, Visitor&)
+{
+    return true;
+}
+
+// 解析报文体并调用访问者，数据域以限定名调用 Load，不经过虚函数
+template <typename FieldType, typename Visitor>
+inline typename std::enable_if<is_field_visitor<Visitor, FieldType>::value, bool>::type
+visit_field(uint32_t, const char* body, size_t body_length, Visitor& visitor)
+{
+    FieldType field;
+    if (!field.FieldType::Load(body, body_length))
+    {
+        return false;
+    }
+    visitor(static_cast<const FieldType&>(field));
+    return true;
+}
+template <typename FieldType, typename Visitor>
+inline typename std::enable_if<!is_field_visitor<Visitor, FieldType>::value, bool>::type
+visit_field(uint32_t msg_type, const char* body, size_t body_length, Visitor& visitor)
+{
+    return visit_unknown(msg_type, body, body_length, visitor);
+}
+
+// 跳转表
+template <typename Visitor>
+struct DispatchEntry
+{
+    uint32_t msg_type;
+    bool (*handler)(uint32_t, const char*, size_t, Visitor&);
+};
+
+// 第 Slot 个表项：哈希到该位置的消息类型，没有则为未知类型
+template <uint32_t Slot, typename Visitor, typename ...Tys>
+struct dispatch_slot
+{
+    static constexpr DispatchEntry<Visitor> entry()
+    {
+        return DispatchEntry<Visitor>{ 0, &visit_unknown<Visitor> };
+    }
+};
+
+template <uint32_t Slot, typename Visitor, typename Ty, typename ...Rest>
+struct dispatch_slot<Slot, Visitor, Ty, Rest...>
+{
+    static constexpr DispatchEntry<Visitor> entry()
+    {
+        return MsgTypeSlot(Ty::kMsgType) == Slot
+            ? DispatchEntry<Visitor>{ Ty::kMsgType, &visit_field<Ty, Visitor> }
+            : dispatch_slot<Slot, Visitor, Rest...>::entry();
+    }
+};
+
+template <uint32_t ...Slots> struct dispatch_slot_sequence {};
+
+template <uint32_t N, uint32_t ...Slots>
+struct make_dispatch_slot_sequence
+    : make_dispatch_slot_sequence<N - 1, N - 1, Slots...>
+{
+};
+
+template <uint32_t ...Slots>
+struct make_dispatch_slot_sequence<0, Slots...>
+{
+    typedef dispatch_slot_sequence<Slots...> type;
+};
+
+template <typename Visitor, typename List, typename Sequence> struct DispatchTable;
+
+// 跳转表为常量初始化，不需要运行期构造
+template <typename Visitor, typename ...Tys, uint32_t ...Slots>
+struct DispatchTable<Visitor, MsgTypeList<Tys...>, dispatch_slot_sequence<Slots...> >
+{
+    static const DispatchEntry<Visitor> entries[sizeof...(Slots)];
+};
+
+template <typename Visitor, typename ...Tys, uint32_t ...Slots>
+const DispatchEntry<Visitor>
+DispatchTable<Visitor, MsgTypeList<Tys...>, dispatch_slot_sequence<Slots...> >::entries[
+    sizeof...(Slots)] = { dispatch_slot<Slots, Visitor, Tys...>::entry()... };
+
+// 热点类型逐个比较，其余类型查跳转表
+template <typename Visitor>
+inline bool dispatch_body(MsgTypeList<>, uint32_t msg_type, const char* body,
+                          size_t body_length, Visitor& visitor)
+{
+    typedef DispatchTable<Visitor, AllMsgTypes,
+        typename make_dispatch_slot_sequence<kMsgTypeSlotCount>::type> table_type;
+    const DispatchEntry<Visitor>& entry = table_type::entries[MsgTypeSlot(msg_type)];
+    if (SZSE_BINARY_UNLIKELY(entry.msg_type != msg_type))
+    {
+        return visit_unknown(msg_type, body, body_length, visitor);
+    }
+    return entry.handler(msg_type, body, body_length, visitor);
+}
+template <typename Visitor, typename Ty, typename ...Rest>
+inline bool dispatch_body(MsgTypeList<Ty, Rest...>, uint32_t msg_type,
+                          const char* body, size_t body_length, Visitor& visitor)
+{
+    if (SZSE_BINARY_LIKELY(msg_type == Ty::kMsgType))
+    {
+        return visit_field<Ty>(msg_type, body, body_length, visitor);
+    }
+    return dispatch_body(MsgTypeList<Rest...>(), msg_type, body, body_length, visitor);
+}
+
+// 按消息类型分发报文体
+// 输入：
+//     msg_type     消息类型
+//     body         报文体起始地址
+//     body_length  报文体长度
+//     visitor      访问者，对需要处理的类型提供 operator()(const immutable_::Xxx&)，
+//                  可选提供 Unknown(uint32_t, const char*, size_t) 处理未知或未接收的类型
+//     HotList      热点消息类型，默认为 HotMsgTypes
+// 输出：
+//     bool         仅在报文体解析失败时为 false
+template <typename HotList = HotMsgTypes, typename Visitor>
+inline bool Dispatch(uint32_t msg_type, const char* body, size_t body_length,
+                     Visitor& visitor)
+{
+    return dispatch_body(HotList(), msg_type, body, body_length, visitor);
+}
+
+// 分发 FrameBatch 结构化的报文
+template <typename HotList = HotMsgTypes, typename Visitor>
+inline bool Dispatch(const PacketRef& ref, Visitor& visitor)
+{
+    return dispatch_body(HotList(), ref.MsgType, ref.BodyAddr, ref.BodyLength, visitor);
+}
+
+// 分发已结构化的报文
+template <typename HotList = HotMsgTypes, typename CheckSumPolicy, bool Probe, typename Visitor>
+inline bool Dispatch(const immutable_::BasicPacket<CheckSumPolicy, Probe>& packet,
+                     Visitor& visitor)
+{
+    const immutable_::MsgHeader* header = packet.GetHeader();
+    return dispatch_body(HotList(), header->MsgType.get_value(), packet.FieldPos(),
+                         header->BodyLength.get_value(), visitor);
+}
+template <typename HotList = HotMsgTypes, typename CheckSumPolicy, bool Probe, typename Visitor>
+inline bool Dispatch(mutable_::BasicPacket<CheckSumPolicy, Probe>& packet, Visitor& visitor)
+{
+    const mutable_::MsgHeader* header = packet.GetHeader();
+    return dispatch_body(HotList(), header->MsgType.get_value(),
+                         packet.ToStream() + mutable_::MsgHeader::SSize,
+                         header->BodyLength.get_value(), visitor);
+}
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_DISPATCH_H__
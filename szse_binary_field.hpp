@@ -1,14 +1,18 @@
-// @Copyright 2017, cao.ning, All Rights Reserved
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
 // @Author:   cao.ning
 // @Date:     2017/02/27
-// @Brief:    V5binaryЭеĻ壬ṩĶд
-//            FieldArrayΪṹ
+// @Brief:    深交所V5binary协议中的基础数据域定义，提供了数据域的读写函数
+//            FieldArray为数据域数组结构
 
 #ifndef __CN_SZSE_BINARY_FIELD_H__
 #define __CN_SZSE_BINARY_FIELD_H__
 
 #include <stdint.h>
 #include <assert.h>
+#include <stdexcept>
+#include <cstddef>
+#include <iterator>
+#include <new>
 #include <type_traits>
 #include <vector>
 
@@ -19,46 +23,117 @@ namespace szse
 namespace binary
 {
 
+// @Class:   FieldLayout
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   定长数据域的编译期布局，Tys 为按报文顺序排列的基础类型
+//           kSize 为总字节数，offset(i) 为第 i 个成员相对数据域起始的偏移
+template <typename ...Tys> struct FieldLayout;
+
+template <> struct FieldLayout<>
+{
+    static const size_t kCount = 0;
+    static const size_t kSize = 0;
+    static constexpr size_t offset(size_t) { return 0; }
+};
+
+template <typename Ty, typename ...Rest>
+struct FieldLayout<Ty, Rest...>
+{
+    typedef FieldLayout<Rest...> rest_type;
+    static const size_t kCount = 1 + sizeof...(Rest);
+    static const size_t kSize = Ty::mem_size() + rest_type::kSize;
+    static constexpr size_t offset(size_t idx)
+    {
+        return idx == 0 ? 0 : Ty::mem_size() + rest_type::offset(idx - 1);
+    }
+};
+
+// 由数据域成员推导其布局类型，仅用于 decltype
+template <typename ...Tys>
+FieldLayout<Tys...> field_layout_of(const Tys&...);
+
+
+// 判断数据域是否定长：定长数据域均定义了 layout_type 与 SSize
+template <typename Ty, typename = void>
+struct is_fixed_field : std::false_type {};
+
+template <typename Ty>
+struct is_fixed_field<Ty, typename std::conditional<
+    false, typename Ty::layout_type, void>::type> : std::true_type {};
+
 
 namespace immutable_
 {
-// ޸ĵݽṹ
+// 不可修改的数据结构数组
+// 加载时仅做长度检查并建立元素位置，元素在访问时才从内存中解析：
+//   定长元素按 SSize 直接计算偏移，不逐个解析
+//   变长元素（如含有 OrderQtyArray 的 SecurityEntry）一次遍历建立偏移索引，
+//   前 kInlineOffsets 个偏移保存在对象内部，超出部分才使用堆内存，
+//   因此每条报文新建的数据域（如 Dispatch 中）解析快照时不分配内存
 template <typename TyField> class FieldArray
 {
-public:
-    FieldArray() : mem_addr_(nullptr), mem_tail_(nullptr), field_count_(0)
+    typedef is_fixed_field<TyField> fixed_type;
+
+    // 变长元素的偏移索引，定长元素不需要
+    template <bool Fixed, typename = void>
+    struct offset_index
     {
-        TyField check_field;
-        field_mem_size_ = check_field.Size();
-    }
+        static const size_t kInlineOffsets = 64;
+        offset_index() : size(0) {}
+        inline void clear() { size = 0; spill.clear(); }
+        inline void push_back(uint32_t offset)
+        {
+            if (SZSE_BINARY_LIKELY(size < kInlineOffsets))
+            {
+                inline_offsets[size] = offset;
+            }
+            else
+            {
+                spill.push_back(offset);
+            }
+            ++size;
+        }
+        inline uint32_t operator[](size_t idx) const
+        {
+            return idx < kInlineOffsets ? inline_offsets[idx] : spill[idx - kInlineOffsets];
+        }
+        size_t size;
+        uint32_t inline_offsets[kInlineOffsets];
+        std::vector<uint32_t> spill;
+    };
+    template <typename Dummy>
+    struct offset_index<true, Dummy>
+    {
+        inline void clear() {}
+    };
+public:
+    class const_iterator;
+
+    FieldArray() : mem_addr_(nullptr), mem_tail_(nullptr), field_count_(0) {}
+
     bool load(const char** mem_addr, size_t* mem_size, size_t load_count)
     {
-        if (mem_addr == nullptr || *mem_addr == nullptr
-            || mem_size == nullptr || load_count == 0)
+        mem_addr_ = mem_tail_ = nullptr;
+        field_count_ = 0;
+        offsets_.clear();
+        if (mem_addr == nullptr || *mem_addr == nullptr || mem_size == nullptr)
         {
             return false;
         }
-        TyField check_field;
-        if (*mem_size < load_count * field_mem_size_)
+        if (!build_index(*mem_addr, *mem_size, load_count, fixed_type()))
         {
             return false;
         }
-        mem_addr_ = mem_tail_ = *mem_addr;
+        mem_addr_ = *mem_addr;
         field_count_ = load_count;
-        while (load_count--)
-        {
-            if (!check_field.Load(mem_tail_, *mem_size))
-            {
-                return false;
-            }
-            mem_tail_ += field_mem_size_;
-            (*mem_size) -= field_mem_size_;
-        }
+        (*mem_size) -= mem_tail_ - mem_addr_;
+        (*mem_addr) = mem_tail_;
         return true;
     }
-    bool write(char** mem_addr, size_t* mem_size)
+    bool write(char**, size_t*)
     {
-        // ṩд
+        // 不提供写函数
         assert(false && "an immutable_ filed array can not write");
         return true;
     }
@@ -69,183 +144,406 @@ public:
     inline size_t count() const { return field_count_; }
     TyField at(size_t idx) const
     {
-        if (idx >= field_count_)
+        TyField item;
+        if (!load_at(idx, &item))
         {
-            throw std::exception("overflow");
+            throw std::out_of_range("overflow");
         }
-        TyField item;
-        item.Load(mem_addr_ + field_mem_size_ * idx, field_mem_size_);
         return item;
     }
+    // 将第 idx 个元素解析到 field 中，不抛出异常
+    bool load_at(size_t idx, TyField* field) const
+    {
+        if (idx >= field_count_ || field == nullptr)
+        {
+            return false;
+        }
+        const char* addr = field_addr(idx);
+        return field->TyField::Load(addr, mem_tail_ - addr);
+    }
+    // 第 idx 个元素在字节流中的起始地址，调用方保证 idx < count()
+    inline const char* field_addr(size_t idx) const
+    {
+        return mem_addr_ + field_offset(idx, fixed_type());
+    }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, field_count_); }
     // memory size
     size_t Size() const
     {
         return mem_tail_ - mem_addr_;
     }
+
+    // 只读前向迭代器，解引用时才解析当前元素，元素直接引用输入字节流
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef TyField value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const TyField* pointer;
+        typedef const TyField& reference;
+
+        const_iterator() : array_(nullptr), idx_(0), loaded_(false) {}
+        const_iterator(const FieldArray* array, size_t idx)
+            : array_(array), idx_(idx), loaded_(false) {}
+
+        reference operator*() const
+        {
+            if (!loaded_)
+            {
+                array_->load_at(idx_, &field_);
+                loaded_ = true;
+            }
+            return field_;
+        }
+        pointer operator->() const { return &**this; }
+        const_iterator& operator++()
+        {
+            ++idx_;
+            loaded_ = false;
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            const_iterator tmp(*this);
+            ++*this;
+            return tmp;
+        }
+        bool operator==(const const_iterator& other) const
+        {
+            return array_ == other.array_ && idx_ == other.idx_;
+        }
+        bool operator!=(const const_iterator& other) const
+        {
+            return !(*this == other);
+        }
+        inline size_t index() const { return idx_; }
+    private:
+        const FieldArray* array_;
+        size_t idx_;
+        mutable TyField field_;
+        mutable bool loaded_;
+    };
+
 private:
+    // 定长元素：一次长度检查
+    bool build_index(const char* mem_addr, size_t mem_size,
+                     size_t load_count, std::true_type)
+    {
+        if (load_count > mem_size / TyField::SSize)
+        {
+            return false;
+        }
+        mem_tail_ = mem_addr + load_count * TyField::SSize;
+        return true;
+    }
+    // 变长元素：逐个解析定长部分以得到实际长度，记录各元素偏移
+    bool build_index(const char* mem_addr, size_t mem_size,
+                     size_t load_count, std::false_type)
+    {
+        TyField check_field;
+        // 每个元素至少包含其定长部分，据此拒绝异常的元素个数
+        size_t min_size = check_field.Size();
+        if (min_size != 0 && load_count > mem_size / min_size)
+        {
+            return false;
+        }
+        const char* tail = mem_addr;
+        while (load_count--)
+        {
+            if (!check_field.TyField::Load(tail, mem_size))
+            {
+                offsets_.clear();
+                return false;
+            }
+            size_t field_size = check_field.Size();
+            offsets_.push_back(static_cast<uint32_t>(tail - mem_addr));
+            tail += field_size;
+            mem_size -= field_size;
+        }
+        mem_tail_ = tail;
+        return true;
+    }
+    inline size_t field_offset(size_t idx, std::true_type) const
+    {
+        return idx * TyField::SSize;
+    }
+    inline size_t field_offset(size_t idx, std::false_type) const
+    {
+        return offsets_[idx];
+    }
+
     const char* mem_addr_;
     const char* mem_tail_;
-    size_t field_count_, field_mem_size_;
+    size_t field_count_;
+    offset_index<fixed_type::value> offsets_;   // 变长元素的偏移索引
 };
 } // namespace immutable_ END
 
 namespace mutable_
 {
-// ޸ĵݽṹ
-template <typename TyField> class FieldArray
+// 可修改的数据结构数组
+// 前 InlineCount 个元素保存在对象内部，超出部分保存在 spill_ 中
+// 元素构造后不再析构，重复 load 时原地解析，嵌套数组的已有容量同样被保留，
+// 因此复用同一对象解析报文时，稳定状态下不再分配堆内存
+template <typename TyField, size_t InlineCount = 0> class FieldArray
 {
 public:
-    FieldArray()
+    FieldArray() : count_(0), inline_built_(0) {}
+    FieldArray(const FieldArray& other) : count_(0), inline_built_(0)
     {
-        TyField check_field;
-        field_mem_size_ = check_field.Size();
+        assign(other);
+    }
+    FieldArray& operator=(const FieldArray& other)
+    {
+        if (this != &other)
+        {
+            assign(other);
+        }
+        return *this;
+    }
+    ~FieldArray()
+    {
+        for (size_t idx = 0; idx < inline_built_; ++idx)
+        {
+            inline_addr()[idx].~TyField();
+        }
     }
 
     bool load(const char** mem_addr, size_t* mem_size, size_t load_count)
     {
-        field_list_.clear();
-        if (mem_addr == nullptr || *mem_addr == nullptr
-            || mem_size == nullptr || load_count == 0)
+        count_ = 0;
+        if (mem_addr == nullptr || *mem_addr == nullptr || mem_size == nullptr)
         {
             return false;
         }
-        TyField load_field;
         while (load_count--)
         {
+            TyField& load_field = acquire(count_);
             if (!load_field.Load(*mem_addr, *mem_size))
             {
-                field_list_.clear();
+                count_ = 0;
                 return false;
             }
-            field_list_.push_back(load_field);
-            (*mem_addr) += field_mem_size_;
-            (*mem_size) -= field_mem_size_;
+            size_t field_size = load_field.Size();
+            (*mem_addr) += field_size;
+            (*mem_size) -= field_size;
+            ++count_;
         }
         return true;
     }
     bool write(char** mem_addr, size_t* mem_size)
     {
-        for (auto &field_ref : field_list_)
+        for (size_t idx = 0; idx < count_; ++idx)
         {
+            TyField& field_ref = slot(idx);
             if (!field_ref.Write(*mem_addr, *mem_size)) { return false; }
-            (*mem_addr) += field_mem_size_;
-            (*mem_size) -= field_mem_size_;
+            size_t field_size = field_ref.Size();
+            (*mem_addr) += field_size;
+            (*mem_size) -= field_size;
         }
         return true;
     }
     void Append(TyField& field)
     {
-        field_list_.push_back(field);
+        acquire(count_) = field;
+        ++count_;
     }
-    // memory size
+    // 在数组尾部追加一个元素并返回，由调用方原地赋值，避免拷贝
+    // 返回的元素可能保留了上次使用时的值
+    TyField* Append()
+    {
+        TyField* field = &acquire(count_);
+        ++count_;
+        return field;
+    }
+    // 清空元素，保留已分配的存储
+    void clear() { count_ = 0; }
+    // memory size，元素可能为变长
     size_t Size() const
     {
-        return field_mem_size_ * count();
+        size_t size = 0;
+        for (size_t idx = 0; idx < count_; ++idx)
+        {
+            size += slot(idx).Size();
+        }
+        return size;
     }
-    inline size_t count() const { return field_list_.size(); }
+    inline size_t count() const { return count_; }
     TyField at(size_t idx) const
     {
-        return field_list_.at(idx);
+        if (idx >= count_)
+        {
+            throw std::out_of_range("overflow");
+        }
+        return slot(idx);
     }
+    // 返回第 idx 个元素的引用，调用方保证 idx < count()
+    inline TyField& operator[](size_t idx) { return slot(idx); }
+    inline const TyField& operator[](size_t idx) const { return slot(idx); }
 private:
-    std::vector<typename TyField> field_list_;
-    size_t field_mem_size_;
+    typedef typename std::aligned_storage<sizeof(TyField),
+                                          alignof(TyField)>::type storage_type;
+
+    inline TyField* inline_addr()
+    {
+        return reinterpret_cast<TyField*>(inline_);
+    }
+    inline const TyField* inline_addr() const
+    {
+        return reinterpret_cast<const TyField*>(inline_);
+    }
+    inline TyField& slot(size_t idx)
+    {
+        return idx < InlineCount ? inline_addr()[idx] : spill_[idx - InlineCount];
+    }
+    inline const TyField& slot(size_t idx) const
+    {
+        return idx < InlineCount ? inline_addr()[idx] : spill_[idx - InlineCount];
+    }
+    // 取得第 idx 个元素，必要时构造，idx 不大于 count_
+    TyField& acquire(size_t idx)
+    {
+        if (idx < InlineCount)
+        {
+            if (idx == inline_built_)
+            {
+                new (inline_addr() + idx) TyField();
+                ++inline_built_;
+            }
+            return inline_addr()[idx];
+        }
+        if (idx - InlineCount == spill_.size())
+        {
+            spill_.emplace_back();
+        }
+        return spill_[idx - InlineCount];
+    }
+    void assign(const FieldArray& other)
+    {
+        count_ = 0;
+        for (size_t idx = 0; idx < other.count_; ++idx)
+        {
+            acquire(idx) = other.slot(idx);
+            ++count_;
+        }
+    }
+
+    size_t count_;
+    size_t inline_built_;   // inline_ 中已构造的元素个数
+    storage_type inline_[InlineCount ? InlineCount : 1];
+    std::vector<TyField> spill_;
 };
 } // namespace mutable_ END
 
-template <is_mutable, typename TyField>
+// InlineCount 为可变数组在对象内部预留的元素个数，不可变数组忽略该参数
+template <is_mutable, typename TyField, size_t InlineCount = 0>
 struct FieldArray : public immutable_::FieldArray<TyField>
 {
 };
 
-template <typename TyField> 
-struct FieldArray <true, TyField> : public mutable_::FieldArray<TyField>
+template <typename TyField, size_t InlineCount>
+struct FieldArray <true, TyField, InlineCount>
+    : public mutable_::FieldArray<TyField, InlineCount>
 {
 };
 
 
 
+// 数据域使用的类型定义
+// 模板派生类中无法直接查找依赖基类 Field<b> 的类型名，各数据域类需通过该宏引入
+#define SZSE_BINARY_FIELD_TYPES(b)                                          \
+    template <typename Ty>                                                  \
+    using TypeInt            = cn::szse::binary::Int<b, Ty>;                \
+                                                                            \
+    template <int x, int y>                                                 \
+    using TypeNumber         = cn::szse::binary::Number<b, x, y>;           \
+                                                                            \
+    using TypeBoolean        = cn::szse::binary::Boolean<b>;                \
+    using TypeLocalTimeStamp = cn::szse::binary::LocalTimeStamp<b>;         \
+    using TypeLocalMktDate   = cn::szse::binary::LocalMktDate<b>;           \
+                                                                            \
+    template <size_t Size>                                                  \
+    using TypeString         = cn::szse::binary::String<b, Size>;           \
+                                                                            \
+    using TypeCompID         = cn::szse::binary::String<b, 20>;             \
+    using TypePrice          = cn::szse::binary::Number<b, 13, 4>;          \
+    using TypeQty            = cn::szse::binary::Number<b, 15, 2>;          \
+    using TypeAmt            = cn::szse::binary::Number<b, 18, 4>;          \
+    using TypeSeqNum         = cn::szse::binary::Int<b, int64_t>;           \
+    using TypeLength         = cn::szse::binary::Int<b, uint32_t>;          \
+    using TypeNumInGroup     = cn::szse::binary::Int<b, uint32_t>;          \
+    using TypeSecurityID     = cn::szse::binary::String<b, 8>;              \
+                                                                            \
+    template <typename Ty, size_t InlineCount = 0>                          \
+    using TypeFieldArray     = cn::szse::binary::FieldArray<b, Ty, InlineCount>;
+
 // @Class:   Field
 // @Author:  cao.ning
 // @Date:    2017/02/21
-// @Brief:   ɸ
+// @Brief:   数据域，由若干个基础数据类型组成
 template <is_mutable b>
 class Field
 {
 protected:
     // type define
-    template <typename Ty>
-    using TypeInt            = Int<b, Ty>;
-
-    template <int x, int y>
-    using TypeNumber         = Number<b, x, y>;
+    SZSE_BINARY_FIELD_TYPES(b)
 
-    using TypeBoolean        = Boolean<b>;
-    using TypeLocalTimeStamp = LocalTimeStamp<b>;
-    using TypeLocalMktDate   = LocalMktDate<b>;
-
-    template <size_t Size>
-    using TypeString         = String<b, Size>;
-
-    using TypeCompID         = String<b, 20>;
-    using TypePrice          = Number<b, 13, 4>;
-    using TypeQty            = Number<b, 15, 2>;
-    using TypeAmt            = Number<b, 18, 4>;
-    using TypeSeqNum         = Int<b, int64_t>;
-    using TypeLength         = Int<b, uint32_t>;
-    using TypeNumInGroup     = Int<b, uint32_t>;
-    using TypeSecurityID     = String<b, 8>;
-
-    template <typename Ty>
-    using TypeFieldArray     = FieldArray<b, Ty>;
-
-    // ڴμ
-    template < typename Ty, typename ...Args >
+    // 从内存中依次加载数据
+    // 按 FieldLayout 做一次整体长度检查，各成员以编译期偏移直接读取
+    template < typename ...Args >
     bool load_from_memory(const char** mem_addr,
                           size_t* mem_size,
-                          Ty& var,
-                          Args&... rest)
+                          Args&... vars)
     {
-        if (mem_addr == nullptr || mem_size == nullptr)
+        typedef FieldLayout<Args...> layout_type;
+        if (mem_addr == nullptr || mem_size == nullptr
+            || *mem_addr == nullptr || *mem_size < layout_type::kSize)
         {
             return false;
         }
-        if (*mem_addr && *mem_size >= Ty::mem_size())
-        {
-            var.load(*mem_addr);
-            (*mem_addr) += Ty::mem_size();
-            (*mem_size) -= Ty::mem_size();
-            return load_from_memory(mem_addr, mem_size, rest...);
-        }
-        return false;
+        load_unchecked(*mem_addr, vars...);
+        (*mem_addr) += layout_type::kSize;
+        (*mem_size) -= layout_type::kSize;
+        return true;
+    }
+    template < typename Ty, typename ...Args >
+    static void load_unchecked(const char* mem_addr, Ty& var, Args&... rest)
+    {
+        var.load(mem_addr);
+        load_unchecked(mem_addr + Ty::mem_size(), rest...);
     }
     // end
-    bool load_from_memory(const char**, size_t*) { return true; }
+    static void load_unchecked(const char*) {}
 
-    // ڴд
-    template < typename Ty, typename ...Args >
+    // 按序向内存写入，长度检查方式同 load_from_memory
+    template < typename ...Args >
     bool write_into_memory(char** mem_addr,
                            size_t* mem_size,
-                           const Ty& var,
-                           const Args&... rest)
+                           const Args&... vars)
     {
-        if (mem_addr == nullptr || mem_size == nullptr)
+        typedef FieldLayout<Args...> layout_type;
+        if (mem_addr == nullptr || mem_size == nullptr
+            || *mem_addr == nullptr || *mem_size < layout_type::kSize)
         {
             return false;
         }
-        if (*mem_addr && *mem_size >= Ty::mem_size())
-        {
-            var.write(*mem_addr);
-            (*mem_addr) += Ty::mem_size();
-            (*mem_size) -= Ty::mem_size();
-            return write_into_memory(mem_addr, mem_size, rest...);
-        }
-        return false;
+        write_unchecked(*mem_addr, vars...);
+        (*mem_addr) += layout_type::kSize;
+        (*mem_size) -= layout_type::kSize;
+        return true;
+    }
+    template < typename Ty, typename ...Args >
+    static void write_unchecked(char* mem_addr, const Ty& var, const Args&... rest)
+    {
+        var.write(mem_addr);
+        write_unchecked(mem_addr + Ty::mem_size(), rest...);
     }
     // end
-    bool write_into_memory(char**, size_t*) { return true; }
+    static void write_unchecked(char*) {}
 
-    // ߴģ
+    // 计算数据域尺寸的模板
     template <typename Ty, typename ...Args>
     size_t byte_size_sum(const Ty&, const Args&... rest) const
     {
@@ -255,11 +553,12 @@ protected:
     size_t byte_size_sum() const { return 0; }
 
 public:
+    virtual ~Field() {}
     virtual uint32_t MsgType() const { return 0; }
     virtual uint32_t Size() const = 0;
-    // ڴм
+    // 从内存中加载
     virtual bool Load(const char* mem_addr, size_t mem_size) = 0;
-    // ǰд뵽ָڴ
+    // 将当前数据写入到指定内存中
     virtual bool Write(char* mem_addr, size_t mem_size) = 0;
 };
 
@@ -271,21 +570,22 @@ public:
 template <is_mutable b>
 class MsgHeader : public Field<b>
 {
+    SZSE_BINARY_FIELD_TYPES(b)
 public:
     static const size_t SSize = sizeof(uint32_t) * 2;
 
-    TypeInt<uint32_t> MsgType;      // Ϣ
-    TypeInt<uint32_t> BodyLength;   // Ϣ峤
+    TypeInt<uint32_t> MsgType;      // 消息类型
+    TypeInt<uint32_t> BodyLength;   // 消息体长度
     // 
     virtual uint32_t Type() const { return 0; }
     virtual uint32_t Size() const { return SSize; }
     virtual bool Load(const char* mem_addr, size_t mem_size) override
     {
-        return load_from_memory(&mem_addr, &mem_size, MsgType, BodyLength);
+        return this->load_from_memory(&mem_addr, &mem_size, MsgType, BodyLength);
     }
     virtual bool Write(char* mem_addr, size_t mem_size) override
     {
-        return write_into_memory(&mem_addr, &mem_size, MsgType, BodyLength);
+        return this->write_into_memory(&mem_addr, &mem_size, MsgType, BodyLength);
     }
 };
 
@@ -0,0 +1,143 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    只读文件映射
+
+#ifndef __CN_SZSE_BINARY_FILE_H__
+#define __CN_SZSE_BINARY_FILE_H__
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+// @Class:   MappedFile
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   只读映射整个文件，空文件视为打开失败；可移动，不可复制
+class MappedFile
+{
+public:
+    MappedFile() : base_(nullptr), size_(0) {}
+    ~MappedFile() { Close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) : base_(nullptr), size_(0)
+    {
+        std::swap(base_, other.base_);
+        std::swap(size_, other.size_);
+    }
+    MappedFile& operator=(MappedFile&& other)
+    {
+        if (this != &other)
+        {
+            Close();
+            std::swap(base_, other.base_);
+            std::swap(size_, other.size_);
+        }
+        return *this;
+    }
+
+    // sequential 为 true 时提示系统按顺序预读
+    bool Open(const std::string& path, bool sequential = true)
+    {
+        Close();
+        return map_file(path, sequential);
+    }
+    void Close()
+    {
+        if (base_)
+        {
+            unmap_file();
+            base_ = nullptr;
+            size_ = 0;
+        }
+    }
+    inline bool Valid() const { return base_ != nullptr; }
+    inline const char* Data() const { return base_; }
+    inline size_t Size() const { return size_; }
+private:
+#if defined(_WIN32)
+    bool map_file(const std::string& path, bool sequential)
+    {
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING,
+                                  sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL,
+                                  nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        LARGE_INTEGER file_size;
+        HANDLE mapping = nullptr;
+        if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+        {
+            mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        }
+        if (mapping)
+        {
+            base_ = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            size_ = base_ ? (size_t)file_size.QuadPart : 0;
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return base_ != nullptr;
+    }
+    void unmap_file()
+    {
+        UnmapViewOfFile(base_);
+    }
+#else
+    bool map_file(const std::string& path, bool sequential)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0)
+        {
+            void* addr = mmap(nullptr, (size_t)file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (addr != MAP_FAILED)
+            {
+                if (sequential)
+                {
+                    madvise(addr, (size_t)file_stat.st_size, MADV_SEQUENTIAL);
+                }
+                base_ = (const char*)addr;
+                size_ = (size_t)file_stat.st_size;
+            }
+        }
+        close(fd);
+        return base_ != nullptr;
+    }
+    void unmap_file()
+    {
+        munmap((void*)base_, size_);
+    }
+#endif
+
+    const char* base_;
+    size_t size_;
+};
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_FILE_H__
@@ -0,0 +1,204 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    订阅过滤，分帧后按报文体中 SecurityID 与 MDStreamID 的固定偏移直接判断，
+//            未订阅的报文在任何字段解析及拷贝之前丢弃
+
+#ifndef __CN_SZSE_BINARY_FILTER_H__
+#define __CN_SZSE_BINARY_FILTER_H__
+
+#include "szse_binary_md_field.hpp"
+#include "szse_binary_packet.hpp"
+#include "szse_binary_symbol.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+// @Class:   SubscriptionFilter
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   证券代码为开放寻址的键集合，槽位数为证券只数的 4 倍以上，
+//           订阅 300 只时共 2048 个槽位（16KB），查找通常一次命中
+//           行情类别为不超过 kMaxMDStreamIDs 个整数标签，顺序比较
+//           未添加证券代码（或行情类别）时不按该项过滤；
+//           不含 SecurityID 或 MDStreamID 的消息（会话、频道心跳、市场状态、公告等）总是通过
+//           REMARK: 逐笔消息被过滤后 ApplSeqNum 不再连续，序号检查（BasicGapTracker）
+//                   须在过滤之前进行
+//           Add* 与 Accept 不能并发调用
+class SubscriptionFilter
+{
+public:
+    static const size_t kMaxMDStreamIDs = 32;
+
+    SubscriptionFilter() : security_count_(0), slot_bits_(0), md_stream_count_(0) {}
+
+    // 订阅证券代码，如 "000001"
+    void AddSecurity(const char* code) { AddSecurityKey(MakeSecurityKey(code)); }
+    void AddSecurity(const std::string& code) { AddSecurityKey(MakeSecurityKey(code)); }
+    void AddSecurityKey(uint64_t key)
+    {
+        if ((security_count_ + 1) * 4 > slots_.size())
+        {
+            rehash(slots_.empty() ? 64 : slots_.size() * 2);
+        }
+        if (insert(key))
+        {
+            ++security_count_;
+        }
+    }
+    // 订阅行情类别，如 "010"；超过 kMaxMDStreamIDs 个时返回 false
+    bool AddMDStreamID(const char* md_stream_id)
+    {
+        char buf[3] = { ' ', ' ', ' ' };
+        for (size_t idx = 0; idx < sizeof(buf) && md_stream_id[idx] != '\0'; ++idx)
+        {
+            buf[idx] = md_stream_id[idx];
+        }
+        uint32_t tag = LoadStringTag<3>(buf);
+        for (size_t idx = 0; idx < md_stream_count_; ++idx)
+        {
+            if (md_streams_[idx] == tag)
+            {
+                return true;
+            }
+        }
+        if (md_stream_count_ == kMaxMDStreamIDs)
+        {
+            return false;
+        }
+        md_streams_[md_stream_count_++] = tag;
+        return true;
+    }
+    void Clear()
+    {
+        slots_.clear();
+        security_count_ = 0;
+        slot_bits_ = 0;
+        md_stream_count_ = 0;
+    }
+
+    inline size_t SecurityCount() const { return security_count_; }
+    inline size_t MDStreamIDCount() const { return md_stream_count_; }
+    // 证券代码是否已订阅，未添加任何证券代码时总是返回 true
+    inline bool ContainsSecurity(uint64_t key) const
+    {
+        return security_count_ == 0 || find(key);
+    }
+
+    // 报文是否通过过滤；报文体过短而无法读取的字段不参与判断，由后续解析报告错误
+    inline bool Accept(uint32_t msg_type, const char* body, size_t body_length) const
+    {
+        uint64_t key = 0;
+        if (security_count_ != 0 && LoadSecurityKey(msg_type, body, body_length, &key)
+            && !find(key))
+        {
+            return false;
+        }
+        uint32_t md_stream_id = 0;
+        if (md_stream_count_ != 0 && LoadMDStreamID(msg_type, body, body_length, &md_stream_id)
+            && !contains_md_stream(md_stream_id))
+        {
+            return false;
+        }
+        return true;
+    }
+    inline bool Accept(const PacketRef& ref) const
+    {
+        return Accept(ref.MsgType, ref.BodyAddr, ref.BodyLength);
+    }
+    // 原地压缩 FrameBatch 或 NextBatch 的结果，只保留通过的报文，保持原有顺序，返回保留的个数
+    size_t Filter(PacketRef* refs, size_t ref_count) const
+    {
+        size_t kept = 0;
+        for (size_t idx = 0; idx < ref_count; ++idx)
+        {
+            refs[kept] = refs[idx];
+            kept += Accept(refs[idx]) ? 1 : 0;
+        }
+        return kept;
+    }
+
+private:
+    inline size_t slot_of(uint64_t key) const
+    {
+        return (size_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - slot_bits_));
+    }
+    // 证券代码右补空格，键不会为 0，以 0 表示空槽位
+    inline bool find(uint64_t key) const
+    {
+        size_t mask = slots_.size() - 1;
+        for (size_t slot = slot_of(key);; slot = (slot + 1) & mask)
+        {
+            uint64_t slot_key = slots_[slot];
+            if (slot_key == key)
+            {
+                return true;
+            }
+            if (slot_key == 0)
+            {
+                return false;
+            }
+        }
+    }
+    bool insert(uint64_t key)
+    {
+        size_t mask = slots_.size() - 1;
+        for (size_t slot = slot_of(key);; slot = (slot + 1) & mask)
+        {
+            if (slots_[slot] == key)
+            {
+                return false;
+            }
+            if (slots_[slot] == 0)
+            {
+                slots_[slot] = key;
+                return true;
+            }
+        }
+    }
+    void rehash(size_t slot_count)
+    {
+        std::vector<uint64_t> old_slots(slot_count, 0);
+        old_slots.swap(slots_);
+        slot_bits_ = 0;
+        while (((size_t)1 << slot_bits_) < slot_count) { ++slot_bits_; }
+        for (size_t idx = 0; idx < old_slots.size(); ++idx)
+        {
+            if (old_slots[idx] != 0)
+            {
+                insert(old_slots[idx]);
+            }
+        }
+    }
+    inline bool contains_md_stream(uint32_t md_stream_id) const
+    {
+        bool found = false;
+        for (size_t idx = 0; idx < md_stream_count_; ++idx)
+        {
+            found |= md_streams_[idx] == md_stream_id;
+        }
+        return found;
+    }
+
+    std::vector<uint64_t> slots_;
+    size_t security_count_;
+    uint32_t slot_bits_;
+    size_t md_stream_count_;
+    uint32_t md_streams_[kMaxMDStreamIDs];
+};
+
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_FILTER_H__
@@ -0,0 +1,363 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    逐笔行情的序号连续性检查，按频道发现缺失区间并生成重传请求（390094），
+//            乱序到达的报文在有界的重排窗口中暂存，补齐后按序交付
+
+#ifndef __CN_SZSE_BINARY_GAP_H__
+#define __CN_SZSE_BINARY_GAP_H__
+
+#include "szse_binary_md_field.hpp"
+#include "szse_binary_packet.hpp"
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+static const uint8_t kResendTypeTick = 1;       // 重传种类：逐笔行情
+static const uint32_t kGapSlotSize = 128;       // 重排窗口每条暂存记录的字节数
+
+// 判断处理者是否提供了 Retransmit(mutable_::Packet&)
+template <typename Handler>
+struct has_retransmit_handler
+{
+private:
+    template <typename H>
+    static auto test(int) -> decltype(std::declval<H&>().Retransmit(
+        std::declval<mutable_::Packet&>()), std::true_type());
+    template <typename H>
+    static std::false_type test(...);
+public:
+    static const bool value = decltype(test<Handler>(0))::value;
+};
+
+template <typename Handler>
+inline typename std::enable_if<has_retransmit_handler<Handler>::value>::type
+send_retransmit(Handler& handler, mutable_::Packet& packet)
+{
+    handler.Retransmit(packet);
+}
+template <typename Handler>
+inline typename std::enable_if<!has_retransmit_handler<Handler>::value>::type
+send_retransmit(Handler&, mutable_::Packet&)
+{
+}
+
+// @Class:   BasicGapTracker
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   逐笔委托与逐笔成交按频道检查 ApplSeqNum，每条报文的处理为 O(1)：
+//               等于期望序号    交付 handler，并依次交付窗口中已补齐的报文
+//               小于期望序号    重复报文，丢弃
+//               大于期望序号    拷贝入重排窗口，新出现的缺失区间生成重传请求
+//           频道心跳的 ApplLastSeqNum 大于已收到的最大序号时，同样请求尾部缺失的区间
+//           超出窗口的报文到达时放弃恢复窗口起点之前的缺失部分，计入 LostCount
+//           重传的报文与实时报文一样调用 Push，补齐缺失后自动按序合并
+//           其余消息类型直接交付，不参与排序
+//           handler 须提供 operator()(const PacketRef&)，可直接使用 Dispatch 的访问者包装；
+//           可选提供 Retransmit(mutable_::Packet&) 发送重传请求，请求报文在下次请求前有效
+//           非线程安全
+template <typename Handler>
+class BasicGapTracker
+{
+    struct slot_header
+    {
+        int64_t     seq;                // 0 表示空
+        uint32_t    msg_type;
+        uint32_t    body_length;
+    };
+    static const uint32_t kSlotBodySize = kGapSlotSize - sizeof(slot_header);
+    struct channel_state
+    {
+        uint16_t    channel_no;
+        int64_t     next_seq;           // 期望的下一个序号，0 表示尚未收到
+        int64_t     high_seq;           // 已收到的最大序号
+        int64_t     requested_seq;      // 已请求重传的最大序号
+        uint32_t    pending;            // 窗口中暂存的报文数
+        std::vector<char> slots;
+    };
+public:
+    // window_size 为每个频道重排窗口的报文条数，向上取整为 2 的幂
+    explicit BasicGapTracker(const Handler& handler = Handler(), uint32_t window_size = 4096)
+        : handler_(handler), window_size_(1), gap_count_(0), duplicate_count_(0),
+          lost_count_(0), request_count_(0), last_channel_(nullptr)
+    {
+        while (window_size_ < window_size) { window_size_ <<= 1; }
+    }
+    BasicGapTracker(const BasicGapTracker&) = delete;
+    BasicGapTracker& operator=(const BasicGapTracker&) = delete;
+
+    // 输入一个报文，返回 false 表示报文被丢弃（重复或无法暂存）
+    bool Push(uint32_t msg_type, const char* body, size_t body_length)
+    {
+        PacketRef ref = { msg_type, (uint32_t)body_length, body };
+        return Push(ref);
+    }
+    bool Push(const PacketRef& ref)
+    {
+        uint16_t channel_no = 0;
+        int64_t seq = 0;
+        if (!LoadApplSeqNum(ref.MsgType, ref.BodyAddr, ref.BodyLength, &channel_no, &seq))
+        {
+            if (ref.MsgType == immutable_::ChannelHeartbeat::kMsgType)
+            {
+                on_heartbeat(ref);
+            }
+            handler_(ref);
+            return true;
+        }
+        channel_state& channel = channel_of(channel_no);
+        if (SZSE_BINARY_UNLIKELY(channel.next_seq == 0))
+        {
+            channel.next_seq = seq;
+        }
+        if (SZSE_BINARY_LIKELY(seq == channel.next_seq))
+        {
+            deliver(channel, ref);
+            if (SZSE_BINARY_UNLIKELY(channel.pending != 0))
+            {
+                drain(channel);
+            }
+            return true;
+        }
+        if (seq < channel.next_seq)
+        {
+            ++duplicate_count_;
+            return false;
+        }
+        if (seq - channel.next_seq >= (int64_t)window_size_)
+        {
+            skip_to(channel, seq - window_size_ + 1);
+        }
+        if (seq == channel.next_seq)
+        {
+            deliver(channel, ref);
+            drain(channel);
+            return true;
+        }
+        return buffer(channel, seq, ref);
+    }
+
+    // 重新请求频道中全部仍缺失的区间，用于重传超时或被拒绝后重试
+    void RequestMissing(uint16_t channel_no)
+    {
+        channel_state& channel = channel_of(channel_no);
+        int64_t begin = 0;
+        for (int64_t seq = channel.next_seq; seq <= channel.high_seq; ++seq)
+        {
+            bool missing = slot_at(channel, seq)->seq != seq;
+            if (missing && begin == 0)
+            {
+                begin = seq;
+            }
+            else if (!missing && begin != 0)
+            {
+                request(channel, begin, seq - 1);
+                begin = 0;
+            }
+        }
+        if (begin == 0)
+        {
+            begin = channel.high_seq + 1;
+        }
+        // 包括频道心跳发现的尾部缺失
+        int64_t end = std::max(channel.high_seq, channel.requested_seq);
+        if (channel.next_seq != 0 && begin <= end)
+        {
+            request(channel, begin, end);
+        }
+    }
+    // 放弃恢复频道中的全部缺失，交付已暂存的报文，计入 LostCount
+    void Skip(uint16_t channel_no)
+    {
+        channel_state& channel = channel_of(channel_no);
+        if (channel.next_seq != 0)
+        {
+            skip_to(channel, channel.high_seq + 1);
+        }
+    }
+
+    // 频道期望的下一个 ApplSeqNum，尚未收到时为 0
+    int64_t Expected(uint16_t channel_no) const
+    {
+        auto it = channels_.find(channel_no);
+        return it == channels_.end() ? 0 : it->second.next_seq;
+    }
+    // 频道重排窗口中暂存的报文数
+    uint32_t Pending(uint16_t channel_no) const
+    {
+        auto it = channels_.find(channel_no);
+        return it == channels_.end() ? 0 : it->second.pending;
+    }
+    // 发现的缺失区间数
+    inline uint64_t GapCount() const { return gap_count_; }
+    inline uint64_t DuplicateCount() const { return duplicate_count_; }
+    // 放弃恢复的报文数
+    inline uint64_t LostCount() const { return lost_count_; }
+    // 生成的重传请求数
+    inline uint64_t RequestCount() const { return request_count_; }
+    inline uint32_t WindowSize() const { return window_size_; }
+    Handler& GetHandler() { return handler_; }
+private:
+    channel_state& channel_of(uint16_t channel_no)
+    {
+        if (last_channel_ == nullptr || last_channel_->channel_no != channel_no)
+        {
+            auto result = channels_.insert(std::make_pair(channel_no, channel_state()));
+            channel_state& channel = result.first->second;
+            if (result.second)
+            {
+                channel.channel_no = channel_no;
+                channel.next_seq = channel.high_seq = channel.requested_seq = 0;
+                channel.pending = 0;
+                channel.slots.assign((size_t)window_size_ * kGapSlotSize, 0);
+            }
+            last_channel_ = &channel;
+        }
+        return *last_channel_;
+    }
+    inline slot_header* slot_at(channel_state& channel, int64_t seq)
+    {
+        size_t idx = (size_t)seq & (window_size_ - 1);
+        return (slot_header*)&channel.slots[idx * kGapSlotSize];
+    }
+    inline void deliver(channel_state& channel, const PacketRef& ref)
+    {
+        handler_(ref);
+        channel.high_seq = std::max(channel.high_seq, channel.next_seq);
+        ++channel.next_seq;
+    }
+    // 交付窗口中从期望序号开始连续的报文
+    void drain(channel_state& channel)
+    {
+        while (channel.pending != 0)
+        {
+            slot_header* slot = slot_at(channel, channel.next_seq);
+            if (slot->seq != channel.next_seq)
+            {
+                break;
+            }
+            PacketRef ref = { slot->msg_type, slot->body_length, (const char*)(slot + 1) };
+            slot->seq = 0;
+            --channel.pending;
+            deliver(channel, ref);
+        }
+    }
+    // 放弃 seq 之前的缺失，交付其间已暂存的报文
+    void skip_to(channel_state& channel, int64_t seq)
+    {
+        while (channel.next_seq < seq)
+        {
+            if (channel.pending == 0)
+            {
+                lost_count_ += seq - channel.next_seq;
+                channel.next_seq = seq;
+                break;
+            }
+            slot_header* slot = slot_at(channel, channel.next_seq);
+            if (slot->seq == channel.next_seq)
+            {
+                PacketRef ref = { slot->msg_type, slot->body_length, (const char*)(slot + 1) };
+                slot->seq = 0;
+                --channel.pending;
+                deliver(channel, ref);
+            }
+            else
+            {
+                ++lost_count_;
+                ++channel.next_seq;
+            }
+        }
+        channel.high_seq = std::max(channel.high_seq, channel.next_seq - 1);
+        channel.requested_seq = std::max(channel.requested_seq, channel.next_seq - 1);
+        drain(channel);
+    }
+    bool buffer(channel_state& channel, int64_t seq, const PacketRef& ref)
+    {
+        slot_header* slot = slot_at(channel, seq);
+        if (slot->seq == seq)
+        {
+            ++duplicate_count_;
+            return false;
+        }
+        if (ref.BodyLength > kSlotBodySize)
+        {
+            return false;
+        }
+        slot->seq = seq;
+        slot->msg_type = ref.MsgType;
+        slot->body_length = ref.BodyLength;
+        memcpy(slot + 1, ref.BodyAddr, ref.BodyLength);
+        ++channel.pending;
+        request_new_gap(channel, seq - 1);
+        channel.high_seq = std::max(channel.high_seq, seq);
+        return true;
+    }
+    // 请求 (已收到或已请求的最大序号, end] 中尚未请求的部分
+    void request_new_gap(channel_state& channel, int64_t end)
+    {
+        int64_t begin = std::max(channel.high_seq, channel.requested_seq) + 1;
+        begin = std::max(begin, channel.next_seq);
+        if (begin <= end)
+        {
+            ++gap_count_;
+            request(channel, begin, end);
+        }
+    }
+    void on_heartbeat(const PacketRef& ref)
+    {
+        typedef immutable_::ChannelHeartbeat::layout_type layout_type;
+        if (ref.BodyLength < layout_type::kSize)
+        {
+            return;
+        }
+        uint16_t channel_no = LoadBigEndian<uint16_t>(ref.BodyAddr + layout_type::offset(0));
+        int64_t last_seq = LoadBigEndian<int64_t>(ref.BodyAddr + layout_type::offset(1));
+        channel_state& channel = channel_of(channel_no);
+        if (channel.next_seq != 0)
+        {
+            request_new_gap(channel, last_seq);
+        }
+    }
+    void request(channel_state& channel, int64_t begin, int64_t end)
+    {
+        mutable_::ReTransmit retransmit;
+        retransmit.ResendType.set_value(kResendTypeTick);
+        retransmit.ChannelNo.set_value(channel.channel_no);
+        retransmit.ApplBegSeqNum.set_value(begin);
+        retransmit.ApplEndSeqNum.set_value(end);
+        channel.requested_seq = std::max(channel.requested_seq, end);
+        ++request_count_;
+        if (request_packet_.InsertField(&retransmit))
+        {
+            send_retransmit(handler_, request_packet_);
+        }
+    }
+
+    Handler handler_;
+    uint32_t window_size_;
+    uint64_t gap_count_;
+    uint64_t duplicate_count_;
+    uint64_t lost_count_;
+    uint64_t request_count_;
+    std::unordered_map<uint16_t, channel_state> channels_;
+    channel_state* last_channel_;       // channels_ 中最近使用的频道
+    mutable_::Packet request_packet_;
+};
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_GAP_H__
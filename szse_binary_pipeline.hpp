@@ -0,0 +1,415 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    按 ChannelNo 分片的并行解码流水线
+//            分帧线程将报文按频道放入各自的单生产者单消费者队列，
+//            每个解码线程负责一组频道并调用处理函数，同一频道内保持报文顺序
+
+#ifndef __CN_SZSE_BINARY_PIPELINE_H__
+#define __CN_SZSE_BINARY_PIPELINE_H__
+
+#include "szse_binary_dispatch.hpp"
+#include "szse_binary_filter.hpp"
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+// @Class:   PacketQueue
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   单生产者单消费者的无锁报文队列，记录为消息类型、报文体长度与报文体，
+//           报文体拷贝进队列，生产者的接收缓冲区可以立即释放
+class PacketQueue
+{
+    struct Record
+    {
+        uint32_t    msg_type;
+        uint32_t    body_length;
+    };
+    static const uint32_t WRAP_MARK = 0xFFFFFFFF;
+public:
+    // size 向上取整为 2 的幂
+    explicit PacketQueue(size_t size = 1 << 20)
+        : ring_size_(64), head_(0), tail_cache_(0), tail_(0), head_cache_(0),
+          front_size_(0)
+    {
+        while (ring_size_ < size) { ring_size_ <<= 1; }
+        ring_ = new char[ring_size_];
+    }
+    ~PacketQueue()
+    {
+        delete[] ring_;
+    }
+    PacketQueue(const PacketQueue&) = delete;
+    PacketQueue& operator=(const PacketQueue&) = delete;
+
+    // 报文体长度是否可以放入队列
+    inline bool Fits(size_t body_length) const
+    {
+        return record_size(body_length) <= ring_size_ / 2;
+    }
+    // 生产者：放入一个报文，队列已满时返回 false
+    bool Push(uint32_t msg_type, const char* body, uint32_t body_length)
+    {
+        size_t need = record_size(body_length);
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        size_t offset = (size_t)(head & (ring_size_ - 1));
+        size_t pad = offset + need > ring_size_ ? ring_size_ - offset : 0;
+        if (need > ring_size_ / 2)
+        {
+            return false;
+        }
+        if (head + pad + need - tail_cache_ > ring_size_)
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head + pad + need - tail_cache_ > ring_size_)
+            {
+                return false;
+            }
+        }
+        if (pad)
+        {
+            ((Record*)(ring_ + offset))->msg_type = WRAP_MARK;
+            head += pad;
+            offset = 0;
+        }
+        Record* record = (Record*)(ring_ + offset);
+        record->msg_type = msg_type;
+        record->body_length = body_length;
+        memcpy(record + 1, body, body_length);
+        head_.store(head + need, std::memory_order_release);
+        return true;
+    }
+    // 消费者：取得队首报文但不出队，ref 指向队列内部，Pop 之前有效
+    bool Front(PacketRef* ref)
+    {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            if (tail == head_cache_)
+            {
+                head_cache_ = head_.load(std::memory_order_acquire);
+                if (tail == head_cache_)
+                {
+                    return false;
+                }
+            }
+            size_t offset = (size_t)(tail & (ring_size_ - 1));
+            const Record* record = (const Record*)(ring_ + offset);
+            if (record->msg_type == WRAP_MARK)
+            {
+                tail += ring_size_ - offset;
+                tail_.store(tail, std::memory_order_release);
+                continue;
+            }
+            ref->MsgType = record->msg_type;
+            ref->BodyLength = record->body_length;
+            ref->BodyAddr = (const char*)(record + 1);
+            front_size_ = record_size(record->body_length);
+            return true;
+        }
+    }
+    // 消费者：队首报文出队
+    inline void Pop()
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + front_size_,
+                    std::memory_order_release);
+    }
+    // 队列是否为空，可由任意线程调用
+    bool Empty() const
+    {
+        return tail_.load(std::memory_order_acquire)
+            == head_.load(std::memory_order_acquire);
+    }
+private:
+    static size_t record_size(size_t body_length)
+    {
+        // 按 8 字节对齐，保证记录头部对齐
+        return (sizeof(Record) + body_length + 7) & ~(size_t)7;
+    }
+
+    char* ring_;
+    size_t ring_size_;
+    // 生产者与消费者各自使用的成员分别位于不同的缓存行
+    char pad0_[64];
+    std::atomic<uint64_t> head_;
+    uint64_t tail_cache_;           // 生产者缓存的 tail_
+    char pad1_[64];
+    std::atomic<uint64_t> tail_;
+    uint64_t head_cache_;           // 消费者缓存的 head_
+    size_t front_size_;
+    char pad2_[64];
+};
+
+// @Class:   BasicDecodePipeline
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   每个频道一个 PacketQueue，频道首次出现时创建并交给所属解码线程；
+//           频道默认按 ChannelNo % 线程数分配，可在 Start 前通过 AddChannel 指定
+//           不含 ChannelNo 的会话消息由 0 号线程处理
+//           每个解码线程持有一份 Handler 的拷贝，通过 Dispatch 调用，
+//           Handler 的要求同 Dispatch 的访问者
+//           Push 与 Feed 只能由同一个分帧线程调用
+template <typename Handler, typename HotList = HotMsgTypes>
+class BasicDecodePipeline
+{
+    static const uint32_t kSessionKey = 0x10000;    // 会话消息的频道键
+    static const size_t kMaxQueuePerWorker = 1024;
+    static const size_t kBatchSize = 64;            // 每次分帧及每个队列每轮出队的最大报文数
+
+    struct Worker
+    {
+        explicit Worker(const Handler& h) : handler(h), queue_count(0), decode_errors(0)
+        {
+            queues.reset(new PacketQueue*[kMaxQueuePerWorker]);
+        }
+        Handler handler;
+        std::unique_ptr<PacketQueue*[]> queues;
+        std::atomic<size_t> queue_count;    // 分帧线程追加队列后发布
+        std::atomic<uint64_t> decode_errors;
+        std::thread thread;
+        int cpu;
+    };
+public:
+    // worker_cpus 中每个元素对应一个解码线程及其绑定的 CPU，-1 表示不绑定
+    // queue_size 为每个频道队列的字节数
+    BasicDecodePipeline(const Handler& handler, const std::vector<int>& worker_cpus,
+                        size_t queue_size = 1 << 20)
+        : queue_size_(queue_size), dropped_(0), filtered_(0), filter_(nullptr), running_(false),
+          route_(kSessionKey + 1, nullptr), assign_(kSessionKey + 1, -1)
+    {
+        size_t worker_count = worker_cpus.empty() ? 1 : worker_cpus.size();
+        for (size_t idx = 0; idx < worker_count; ++idx)
+        {
+            workers_.emplace_back(new Worker(handler));
+            workers_.back()->cpu = worker_cpus.empty() ? -1 : worker_cpus[idx];
+        }
+        assign_[kSessionKey] = 0;
+    }
+    ~BasicDecodePipeline()
+    {
+        Stop();
+    }
+    BasicDecodePipeline(const BasicDecodePipeline&) = delete;
+    BasicDecodePipeline& operator=(const BasicDecodePipeline&) = delete;
+
+    // 指定频道由第 worker 个解码线程处理，须在 Start 之前调用
+    bool AddChannel(uint16_t channel_no, size_t worker)
+    {
+        if (running_ || worker >= workers_.size() || route_[channel_no])
+        {
+            return false;
+        }
+        assign_[channel_no] = (int)worker;
+        return true;
+    }
+    // 设置订阅过滤，Feed 分帧后丢弃未订阅的报文，不放入队列；nullptr 为不过滤
+    // filter 在流水线运行期间须保持有效且不被修改
+    void SetFilter(const SubscriptionFilter* filter)
+    {
+        filter_ = filter;
+    }
+    void Start()
+    {
+        if (running_.exchange(true))
+        {
+            return;
+        }
+        for (auto &worker : workers_)
+        {
+            worker->thread = std::thread(&BasicDecodePipeline::run, this, worker.get());
+            SetThreadAffinity(worker->thread, worker->cpu);
+        }
+    }
+    // 处理完所有已放入的报文后停止解码线程
+    void Stop()
+    {
+        if (!running_.exchange(false))
+        {
+            return;
+        }
+        for (auto &worker : workers_)
+        {
+            if (worker->thread.joinable())
+            {
+                worker->thread.join();
+            }
+        }
+    }
+    // 放入一个报文，队列已满时等待；以下情况返回 false 并计入 Dropped：
+    // 报文体超过队列容量的一半，或流水线未运行（未 Start、已 Stop 或等待期间被 Stop）
+    bool Push(const PacketRef& ref)
+    {
+        if (SZSE_BINARY_UNLIKELY(!running_.load(std::memory_order_relaxed)))
+        {
+            ++dropped_;
+            return false;
+        }
+        uint16_t channel_no = 0;
+        uint32_t key = LoadChannelNo(ref.MsgType, ref.BodyAddr, ref.BodyLength, &channel_no)
+            ? channel_no : kSessionKey;
+        PacketQueue* queue = route_[key];
+        if (SZSE_BINARY_UNLIKELY(queue == nullptr))
+        {
+            queue = create_queue(key);
+            if (queue == nullptr)
+            {
+                ++dropped_;
+                return false;
+            }
+        }
+        if (SZSE_BINARY_UNLIKELY(!queue->Fits(ref.BodyLength)))
+        {
+            ++dropped_;
+            return false;
+        }
+        while (!queue->Push(ref.MsgType, ref.BodyAddr, ref.BodyLength))
+        {
+            // 解码线程已退出时队列不会再腾出空间
+            if (!running_.load(std::memory_order_relaxed))
+            {
+                ++dropped_;
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+    // 对字节流分帧并放入队列，参数与返回值的含义同 FrameBatch
+    template <typename CheckSumPolicy>
+    bool Feed(const char* mem_addr, size_t* mem_size, CheckSumPolicy& policy)
+    {
+        PacketRef refs[kBatchSize];
+        size_t remain = *mem_size;
+        bool result = true;
+        for (;;)
+        {
+            size_t ref_count = kBatchSize;
+            size_t batch_size = remain;
+            result = FrameBatch(mem_addr, &batch_size, refs, &ref_count, policy);
+            for (size_t idx = 0; idx < ref_count; ++idx)
+            {
+                if (filter_ != nullptr && !filter_->Accept(refs[idx]))
+                {
+                    ++filtered_;
+                    continue;
+                }
+                Push(refs[idx]);
+            }
+            mem_addr += remain - batch_size;
+            remain = batch_size;
+            if (!result || ref_count < kBatchSize)
+            {
+                break;
+            }
+        }
+        *mem_size = remain;
+        return result;
+    }
+    bool Feed(const char* mem_addr, size_t* mem_size)
+    {
+        CheckSumVerify policy;
+        return Feed(mem_addr, mem_size, policy);
+    }
+    // 所有队列是否为空，由分帧线程调用
+    bool Idle() const
+    {
+        for (auto &queue : queues_)
+        {
+            if (!queue->Empty())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    // Push 与 Feed 中无法放入队列而丢弃的报文数
+    inline uint64_t Dropped() const { return dropped_; }
+    // Feed 中被订阅过滤丢弃的报文数
+    inline uint64_t Filtered() const { return filtered_; }
+    inline size_t WorkerCount() const { return workers_.size(); }
+    // 第 worker 个解码线程的处理函数，解码线程运行期间访问需由调用方同步
+    Handler& GetHandler(size_t worker) { return workers_[worker]->handler; }
+    // 第 worker 个解码线程遇到的报文体解析失败次数
+    uint64_t DecodeErrors(size_t worker) const
+    {
+        return workers_[worker]->decode_errors.load(std::memory_order_relaxed);
+    }
+private:
+    PacketQueue* create_queue(uint32_t key)
+    {
+        size_t worker_idx = assign_[key] >= 0 ? (size_t)assign_[key]
+                                              : key % workers_.size();
+        Worker& worker = *workers_[worker_idx];
+        size_t count = worker.queue_count.load(std::memory_order_relaxed);
+        if (count >= kMaxQueuePerWorker)
+        {
+            return nullptr;
+        }
+        queues_.emplace_back(new PacketQueue(queue_size_));
+        PacketQueue* queue = queues_.back().get();
+        worker.queues[count] = queue;
+        worker.queue_count.store(count + 1, std::memory_order_release);
+        route_[key] = queue;
+        return queue;
+    }
+    void run(Worker* worker)
+    {
+        PacketRef ref;
+        for (;;)
+        {
+            // 先读取 running_，退出前保证所有队列已处理完
+            bool running = running_.load(std::memory_order_acquire);
+            size_t queue_count = worker->queue_count.load(std::memory_order_acquire);
+            bool busy = false;
+            for (size_t idx = 0; idx < queue_count; ++idx)
+            {
+                PacketQueue* queue = worker->queues[idx];
+                for (size_t n = 0; n < kBatchSize && queue->Front(&ref); ++n)
+                {
+                    if (!Dispatch<HotList>(ref, worker->handler))
+                    {
+                        worker->decode_errors.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    queue->Pop();
+                    busy = true;
+                }
+            }
+            if (!busy)
+            {
+                if (!running)
+                {
+                    break;
+                }
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    size_t queue_size_;
+    uint64_t dropped_;
+    uint64_t filtered_;
+    const SubscriptionFilter* filter_;
+    std::atomic<bool> running_;
+    std::vector<std::unique_ptr<Worker> > workers_;
+    std::vector<std::unique_ptr<PacketQueue> > queues_;
+    std::vector<PacketQueue*> route_;   // 频道键到队列，仅分帧线程访问
+    std::vector<int> assign_;           // 频道键到解码线程，-1 表示默认分配
+};
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_PIPELINE_H__
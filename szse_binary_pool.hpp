@@ -0,0 +1,299 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    可变报文对象池，报文与字节流缓冲区按尺寸等级预先分配在连续的内存块中，
+//            通过引用计数在多个消费者之间共享，引用归零后回收复用
+
+#ifndef __CN_SZSE_BINARY_POOL_H__
+#define __CN_SZSE_BINARY_POOL_H__
+
+#include "szse_binary_packet.hpp"
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+template <typename CheckSumPolicy> class BasicPacketPool;
+
+// @Class:   PooledPacket
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   由 BasicPacketPool 分配的可变报文，字节流缓冲区位于对象池的内存块中
+//           AddRef/Release 维护引用计数，引用归零时回到对象池
+//           写入超过缓冲区容量的报文时改为自行分配，回收时恢复使用内存块
+template <typename CheckSumPolicy>
+class PooledPacket : public mutable_::BasicPacket<CheckSumPolicy>
+{
+    typedef mutable_::BasicPacket<CheckSumPolicy> base_type;
+    friend class BasicPacketPool<CheckSumPolicy>;
+public:
+    inline void AddRef()
+    {
+        ref_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    inline void Release()
+    {
+        if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            pool_->recycle(this);
+        }
+    }
+    inline uint32_t RefCount() const
+    {
+        return ref_count_.load(std::memory_order_relaxed);
+    }
+private:
+    typedef typename BasicPacketPool<CheckSumPolicy>::ThreadCache cache_type;
+
+    PooledPacket(BasicPacketPool<CheckSumPolicy>* pool, cache_type* owner,
+                 size_t size_class, char* stream, uint32_t stream_size,
+                 const CheckSumPolicy& policy)
+        : base_type(stream, stream_size, policy), ref_count_(0), pool_(pool),
+          owner_(owner), size_class_(size_class), slab_stream_(stream),
+          slab_stream_size_(stream_size), next_(nullptr)
+    {
+    }
+    // 恢复使用内存块中的缓冲区
+    void restore_stream()
+    {
+        if (this->own_stream())
+        {
+            this->attach_stream(slab_stream_, slab_stream_size_);
+        }
+    }
+
+    std::atomic<uint32_t> ref_count_;
+    BasicPacketPool<CheckSumPolicy>* pool_;
+    cache_type* owner_;             // 所属线程缓存
+    size_t size_class_;
+    char* slab_stream_;
+    uint32_t slab_stream_size_;
+    PooledPacket* next_;            // 空闲链表
+};
+
+// @Class:   BasicPacketPool
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   可变报文对象池，缓冲区按 256B、1KB、4KB、16KB、64KB 分为 5 个尺寸等级
+//           每个线程持有各等级的空闲链表，本线程分配与回收无需同步；
+//           其他线程回收的报文压入所属线程的远程链表（无锁），
+//           所属线程在本地链表为空时一次取回，内存块只在对象池析构时释放
+//           报文不再清零缓冲区，线程退出后其缓存中的报文不会被其他线程复用
+//           对象池析构前所有报文须已回收
+template <typename CheckSumPolicy = CheckSumVerify>
+class BasicPacketPool
+{
+    friend class PooledPacket<CheckSumPolicy>;
+public:
+    typedef PooledPacket<CheckSumPolicy> packet_type;
+    static const size_t kClassCount = 5;
+    static const uint32_t kMinStreamSize = 256;
+    static const uint32_t kMaxStreamSize = kMinStreamSize << (2 * (kClassCount - 1));
+
+    // slab_count 为每次扩充时单个内存块包含的报文个数
+    explicit BasicPacketPool(size_t slab_count = 64,
+                             const CheckSumPolicy& policy = CheckSumPolicy())
+        : slab_count_(slab_count ? slab_count : 1), policy_(policy),
+          pool_id_(next_pool_id())
+    {
+    }
+    ~BasicPacketPool()
+    {
+        for (auto &slab : slabs_)
+        {
+            for (size_t idx = 0; idx < slab.count; ++idx)
+            {
+                reinterpret_cast<packet_type*>(
+                    slab.mem_addr + idx * slab.stride)->~packet_type();
+            }
+            ::operator delete(slab.mem_base);
+        }
+        for (auto cache : caches_)
+        {
+            delete cache;
+        }
+    }
+    BasicPacketPool(const BasicPacketPool&) = delete;
+    BasicPacketPool& operator=(const BasicPacketPool&) = delete;
+
+    // 分配缓冲区不小于 stream_size 的报文，引用计数为 1
+    // 超过 kMaxStreamSize 的报文从最大等级分配，写入时自行扩充
+    packet_type* Acquire(uint32_t stream_size)
+    {
+        size_t size_class = class_of(stream_size);
+        ThreadCache* cache = local_cache();
+        packet_type* packet = cache->free[size_class];
+        if (packet == nullptr)
+        {
+            // 取回其他线程回收的报文
+            packet = cache->remote[size_class].exchange(nullptr,
+                                                        std::memory_order_acquire);
+            if (packet == nullptr)
+            {
+                packet = grow(cache, size_class);
+            }
+        }
+        cache->free[size_class] = packet->next_;
+        packet->next_ = nullptr;
+        packet->ref_count_.store(1, std::memory_order_relaxed);
+        return packet;
+    }
+    // 按报文头中的长度分配报文并结构化，失败时回收报文并返回 nullptr
+    // mem_size 的含义同 mutable_::BasicPacket::Structure
+    packet_type* Structure(const char* mem_addr, size_t* mem_size)
+    {
+        if (mem_addr == nullptr || mem_size == nullptr
+            || *mem_size < immutable_::MsgHeader::SSize)
+        {
+            if (mem_size) { *mem_size = immutable_::MsgHeader::SSize; }
+            return nullptr;
+        }
+        uint32_t stream_size = immutable_::MsgHeader::SSize + sizeof(uint32_t)
+            + LoadBigEndian<uint32_t>(mem_addr + sizeof(uint32_t));
+        packet_type* packet = Acquire(stream_size);
+        if (!packet->Structure(mem_addr, mem_size))
+        {
+            packet->Release();
+            return nullptr;
+        }
+        return packet;
+    }
+private:
+    // 线程缓存
+    struct ThreadCache
+    {
+        ThreadCache()
+        {
+            for (size_t idx = 0; idx < kClassCount; ++idx)
+            {
+                free[idx] = nullptr;
+                remote[idx].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+        packet_type* free[kClassCount];                 // 仅所属线程访问
+        std::atomic<packet_type*> remote[kClassCount];  // 其他线程回收的报文
+    };
+    struct Slab
+    {
+        void* mem_base;
+        char* mem_addr;     // 按 64 字节对齐
+        size_t count;
+        size_t stride;
+    };
+
+    static size_t class_of(uint32_t stream_size)
+    {
+        size_t size_class = 0;
+        uint32_t class_size = kMinStreamSize;
+        while (size_class + 1 < kClassCount && class_size < stream_size)
+        {
+            class_size <<= 2;
+            ++size_class;
+        }
+        return size_class;
+    }
+    static uint64_t next_pool_id()
+    {
+        static std::atomic<uint64_t> pool_id(0);
+        return ++pool_id;
+    }
+    // 当前线程在本对象池中的缓存，首次访问时创建
+    ThreadCache* local_cache()
+    {
+        struct CacheSlot
+        {
+            uint64_t pool_id;
+            ThreadCache* cache;
+        };
+        static thread_local CacheSlot last_slot = { 0, nullptr };
+        static thread_local std::vector<CacheSlot> slots;
+        if (last_slot.pool_id == pool_id_)
+        {
+            return last_slot.cache;
+        }
+        for (auto &slot : slots)
+        {
+            if (slot.pool_id == pool_id_)
+            {
+                last_slot = slot;
+                return slot.cache;
+            }
+        }
+        ThreadCache* cache = new ThreadCache();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            caches_.push_back(cache);
+        }
+        CacheSlot slot = { pool_id_, cache };
+        slots.push_back(slot);
+        last_slot = slot;
+        return cache;
+    }
+    // 为 cache 新增一个内存块，返回空闲链表头
+    packet_type* grow(ThreadCache* cache, size_t size_class)
+    {
+        uint32_t stream_size = kMinStreamSize << (2 * size_class);
+        Slab slab;
+        slab.count = slab_count_;
+        slab.stride = (sizeof(packet_type) + stream_size + 63) / 64 * 64;
+        slab.mem_base = ::operator new(slab.count * slab.stride + 64);
+        slab.mem_addr = reinterpret_cast<char*>(
+            (reinterpret_cast<uintptr_t>(slab.mem_base) + 63) & ~uintptr_t(63));
+        packet_type* head = nullptr;
+        for (size_t idx = slab.count; idx--; )
+        {
+            char* entry = slab.mem_addr + idx * slab.stride;
+            packet_type* packet = new (entry) packet_type(this, cache, size_class,
+                entry + sizeof(packet_type), stream_size, policy_);
+            packet->next_ = head;
+            head = packet;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slabs_.push_back(slab);
+        }
+        return head;
+    }
+    void recycle(packet_type* packet)
+    {
+        packet->restore_stream();
+        ThreadCache* owner = packet->owner_;
+        size_t size_class = packet->size_class_;
+        if (owner == local_cache())
+        {
+            packet->next_ = owner->free[size_class];
+            owner->free[size_class] = packet;
+            return;
+        }
+        // 多个线程压入、所属线程整体取出，不存在 ABA 问题
+        packet_type* head = owner->remote[size_class].load(std::memory_order_relaxed);
+        do
+        {
+            packet->next_ = head;
+        } while (!owner->remote[size_class].compare_exchange_weak(head, packet,
+                    std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    size_t slab_count_;
+    CheckSumPolicy policy_;
+    uint64_t pool_id_;
+    std::mutex mutex_;                  // 仅保护 slabs_ 与 caches_ 的扩充
+    std::vector<Slab> slabs_;
+    std::vector<ThreadCache*> caches_;
+};
+typedef BasicPacketPool<CheckSumVerify> PacketPool;
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_POOL_H__
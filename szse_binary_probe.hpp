@@ -0,0 +1,541 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    解析耗时探针，按消息类型记录 Structure、校验和、GetField 的时钟周期分布，
+//            按频道记录字节数与报文数；由报文类的模板参数开启，关闭时不产生任何代码
+
+#ifndef __CN_SZSE_BINARY_PROBE_H__
+#define __CN_SZSE_BINARY_PROBE_H__
+
+#include "szse_binary_md_field.hpp"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+// 是否支持时间戳计数器；不支持时 ReadTSC 返回单调时钟的纳秒数
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) \
+    || (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+static const bool kHasTSC = true;
+#else
+static const bool kHasTSC = false;
+#endif
+
+// 读取时间戳计数器
+inline uint64_t ReadTSC()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_ia32_rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// 探针记录的阶段
+enum ProbeStage
+{
+    kProbeStructure = 0,        // Structure 全程，含校验和
+    kProbeCheckSum,             // 校验和
+    kProbeGetField,             // GetField
+    kProbeStageCount
+};
+inline const char* ProbeStageName(uint32_t stage)
+{
+    static const char* kNames[kProbeStageCount] = { "Structure", "CheckSum", "GetField" };
+    return stage < kProbeStageCount ? kNames[stage] : "";
+}
+
+// 直方图按 2 的幂分段，每段再等分为 16 档，相对误差不超过 1/16（同 HDR Histogram）
+// 小于 16 的值各占一档，超过 2^kHistogramMaxBits 的值计入最后一档
+static const uint32_t kHistogramSubBits = 4;
+static const uint32_t kHistogramMaxBits = 40;
+static const uint32_t kHistogramBucketCount =
+    (kHistogramMaxBits - kHistogramSubBits + 2) << kHistogramSubBits;
+
+// 最高位 1 的位置，value 不为 0
+inline uint32_t HighestBit(uint64_t value)
+{
+    return 63 - CountLeadingZeros64(value);
+}
+
+inline uint32_t HistogramBucket(uint64_t value)
+{
+    const uint64_t sub_count = 1u << kHistogramSubBits;
+    if (value < sub_count)
+    {
+        return (uint32_t)value;
+    }
+    uint32_t magnitude = HighestBit(value);
+    if (magnitude > kHistogramMaxBits)
+    {
+        return kHistogramBucketCount - 1;
+    }
+    uint32_t sub = (uint32_t)(value >> (magnitude - kHistogramSubBits)) & (sub_count - 1);
+    return ((magnitude - kHistogramSubBits + 1) << kHistogramSubBits) + sub;
+}
+// 档位可表示的最大值
+inline uint64_t HistogramBucketMax(uint32_t bucket)
+{
+    const uint32_t sub_count = 1u << kHistogramSubBits;
+    if (bucket < sub_count)
+    {
+        return bucket;
+    }
+    uint32_t shift = (bucket >> kHistogramSubBits) - 1;
+    uint64_t low = (uint64_t)(sub_count + (bucket & (sub_count - 1))) << shift;
+    return low + ((uint64_t)1 << shift) - 1;
+}
+
+// 直方图的快照，可由多个线程的直方图合并而来
+struct HistogramSnapshot
+{
+    uint64_t Count;
+    uint64_t Sum;
+    uint64_t Max;
+    uint64_t Buckets[kHistogramBucketCount];
+
+    HistogramSnapshot() { Clear(); }
+    void Clear()
+    {
+        Count = Sum = Max = 0;
+        memset(Buckets, 0, sizeof(Buckets));
+    }
+    inline double Mean() const { return Count ? (double)Sum / (double)Count : 0; }
+    // 分位数，如 0.999；返回所在档位的最大值，不超过记录到的最大值
+    uint64_t Percentile(double quantile) const
+    {
+        if (Count == 0)
+        {
+            return 0;
+        }
+        uint64_t rank = (uint64_t)(quantile * (double)Count + 0.5);
+        rank = rank == 0 ? 1 : rank > Count ? Count : rank;
+        uint64_t seen = 0;
+        for (uint32_t bucket = 0; bucket < kHistogramBucketCount; ++bucket)
+        {
+            seen += Buckets[bucket];
+            if (seen >= rank)
+            {
+                uint64_t value = HistogramBucketMax(bucket);
+                return value < Max ? value : Max;
+            }
+        }
+        return Max;
+    }
+};
+
+// @Class:   LatencyHistogram
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   只由一个线程写入的直方图，写入不使用原子读改写指令；
+//           任意线程可随时读取快照，快照中各计数之间可能相差正在写入的一次
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() : count_(0), sum_(0), max_(0)
+    {
+        for (uint32_t bucket = 0; bucket < kHistogramBucketCount; ++bucket)
+        {
+            buckets_[bucket].store(0, std::memory_order_relaxed);
+        }
+    }
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    inline void Record(uint64_t value)
+    {
+        std::atomic<uint64_t>& bucket = buckets_[HistogramBucket(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed))
+        {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+    // 合并到 snapshot 中
+    void Load(HistogramSnapshot* snapshot) const
+    {
+        for (uint32_t bucket = 0; bucket < kHistogramBucketCount; ++bucket)
+        {
+            snapshot->Buckets[bucket] += buckets_[bucket].load(std::memory_order_relaxed);
+        }
+        snapshot->Count += count_.load(std::memory_order_relaxed);
+        snapshot->Sum += sum_.load(std::memory_order_relaxed);
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        snapshot->Max = max > snapshot->Max ? max : snapshot->Max;
+    }
+private:
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+    std::atomic<uint64_t> buckets_[kHistogramBucketCount];
+};
+
+static const uint32_t kProbeMsgTypeBits = 6;
+static const uint32_t kProbeMsgTypeSlots = 1u << kProbeMsgTypeBits;    // 每个线程最多记录的消息类型数
+static const uint32_t kProbeChannelSlots = 256;     // 每个线程最多记录的频道数
+
+// @Class:   ThreadProbe
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   一个线程的探针数据，只由所属线程写入
+//           消息类型与频道各自以开放寻址表定位，消息类型的直方图在首次出现时分配；
+//           表满后新出现的消息类型或频道不再记录
+class ThreadProbe
+{
+    struct type_slot
+    {
+        std::atomic<uint32_t>           msg_type;       // 0 表示空
+        std::atomic<LatencyHistogram*>  histograms;     // kProbeStageCount 个
+    };
+    struct channel_slot
+    {
+        std::atomic<uint32_t>   key;                    // ChannelNo + 1，0 表示空
+        std::atomic<uint64_t>   bytes;
+        std::atomic<uint64_t>   messages;
+    };
+public:
+    ThreadProbe() : next_(nullptr)
+    {
+        for (uint32_t idx = 0; idx < kProbeMsgTypeSlots; ++idx)
+        {
+            type_slots_[idx].msg_type.store(0, std::memory_order_relaxed);
+            type_slots_[idx].histograms.store(nullptr, std::memory_order_relaxed);
+        }
+        for (uint32_t idx = 0; idx < kProbeChannelSlots; ++idx)
+        {
+            channel_slots_[idx].key.store(0, std::memory_order_relaxed);
+            channel_slots_[idx].bytes.store(0, std::memory_order_relaxed);
+            channel_slots_[idx].messages.store(0, std::memory_order_relaxed);
+        }
+    }
+    ~ThreadProbe()
+    {
+        for (uint32_t idx = 0; idx < kProbeMsgTypeSlots; ++idx)
+        {
+            delete[] type_slots_[idx].histograms.load(std::memory_order_relaxed);
+        }
+    }
+    ThreadProbe(const ThreadProbe&) = delete;
+    ThreadProbe& operator=(const ThreadProbe&) = delete;
+
+    inline void Record(uint32_t msg_type, ProbeStage stage, uint64_t cycles)
+    {
+        LatencyHistogram* histograms = find_type(msg_type);
+        if (histograms)
+        {
+            histograms[stage].Record(cycles);
+        }
+    }
+    inline void Count(uint16_t channel_no, uint64_t bytes)
+    {
+        uint32_t key = (uint32_t)channel_no + 1;
+        for (uint32_t probe = 0, pos = key & (kProbeChannelSlots - 1); probe < kProbeChannelSlots;
+             ++probe, pos = (pos + 1) & (kProbeChannelSlots - 1))
+        {
+            channel_slot& slot = channel_slots_[pos];
+            uint32_t slot_key = slot.key.load(std::memory_order_relaxed);
+            if (slot_key == 0)
+            {
+                slot.key.store(key, std::memory_order_release);
+            }
+            else if (slot_key != key)
+            {
+                continue;
+            }
+            slot.bytes.store(slot.bytes.load(std::memory_order_relaxed) + bytes,
+                             std::memory_order_relaxed);
+            slot.messages.store(slot.messages.load(std::memory_order_relaxed) + 1,
+                                std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    // 以下由读取快照的线程调用
+    // 第 idx 个消息类型槽位，空槽位返回 0
+    inline uint32_t MsgTypeAt(uint32_t idx) const
+    {
+        return type_slots_[idx].histograms.load(std::memory_order_acquire)
+            ? type_slots_[idx].msg_type.load(std::memory_order_relaxed) : 0;
+    }
+    inline const LatencyHistogram& HistogramAt(uint32_t idx, ProbeStage stage) const
+    {
+        return type_slots_[idx].histograms.load(std::memory_order_acquire)[stage];
+    }
+    // 第 idx 个频道槽位，空槽位返回 false
+    bool ChannelAt(uint32_t idx, uint16_t* channel_no, uint64_t* bytes, uint64_t* messages) const
+    {
+        const channel_slot& slot = channel_slots_[idx];
+        uint32_t key = slot.key.load(std::memory_order_acquire);
+        if (key == 0)
+        {
+            return false;
+        }
+        *channel_no = (uint16_t)(key - 1);
+        *bytes = slot.bytes.load(std::memory_order_relaxed);
+        *messages = slot.messages.load(std::memory_order_relaxed);
+        return true;
+    }
+    inline ThreadProbe* Next() const { return next_; }
+private:
+    friend class ProbeRegistry;
+
+    LatencyHistogram* find_type(uint32_t msg_type)
+    {
+        uint32_t pos = (msg_type * 0x9E3779B1u) >> (32 - kProbeMsgTypeBits);
+        for (uint32_t probe = 0; probe < kProbeMsgTypeSlots;
+             ++probe, pos = (pos + 1) & (kProbeMsgTypeSlots - 1))
+        {
+            type_slot& slot = type_slots_[pos];
+            uint32_t slot_type = slot.msg_type.load(std::memory_order_relaxed);
+            if (slot_type == msg_type)
+            {
+                return slot.histograms.load(std::memory_order_relaxed);
+            }
+            if (slot_type == 0)
+            {
+                // 先写入类型，再以 release 发布直方图
+                LatencyHistogram* histograms = new LatencyHistogram[kProbeStageCount];
+                slot.msg_type.store(msg_type, std::memory_order_relaxed);
+                slot.histograms.store(histograms, std::memory_order_release);
+                return histograms;
+            }
+        }
+        return nullptr;
+    }
+
+    type_slot type_slots_[kProbeMsgTypeSlots];
+    channel_slot channel_slots_[kProbeChannelSlots];
+    ThreadProbe* next_;
+};
+
+// 单个消息类型的统计
+struct ProbeTypeStats
+{
+    uint32_t MsgType;
+    HistogramSnapshot Stages[kProbeStageCount];
+};
+// 单个频道的统计，会话消息计入频道 0
+struct ProbeChannelStats
+{
+    uint16_t ChannelNo;
+    uint64_t Bytes;         // 含报文头与校验和
+    uint64_t Messages;
+};
+
+// @Class:   ProbeSnapshot
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   全部线程探针数据的合并结果，按消息类型与频道号升序排列
+struct ProbeSnapshot
+{
+    uint32_t ThreadCount;
+    std::vector<ProbeTypeStats> Types;
+    std::vector<ProbeChannelStats> Channels;
+
+    ProbeSnapshot() : ThreadCount(0) {}
+    const ProbeTypeStats* Find(uint32_t msg_type) const
+    {
+        for (size_t idx = 0; idx < Types.size(); ++idx)
+        {
+            if (Types[idx].MsgType == msg_type)
+            {
+                return &Types[idx];
+            }
+        }
+        return nullptr;
+    }
+    // 文本报表，每个消息类型每个阶段一行：次数、平均、p50、p99、p99.9、最大值（时钟周期）
+    std::string ToString() const
+    {
+        std::string text;
+        char line[256];
+        snprintf(line, sizeof(line), "%-8s %-10s %12s %10s %10s %10s %10s %12s\n",
+                 "MsgType", "Stage", "Count", "Mean", "p50", "p99", "p99.9", "Max");
+        text += line;
+        for (size_t idx = 0; idx < Types.size(); ++idx)
+        {
+            for (uint32_t stage = 0; stage < kProbeStageCount; ++stage)
+            {
+                const HistogramSnapshot& histogram = Types[idx].Stages[stage];
+                if (histogram.Count == 0)
+                {
+                    continue;
+                }
+                snprintf(line, sizeof(line),
+                         "%-8u %-10s %12llu %10.1f %10llu %10llu %10llu %12llu\n",
+                         Types[idx].MsgType, ProbeStageName(stage),
+                         (unsigned long long)histogram.Count, histogram.Mean(),
+                         (unsigned long long)histogram.Percentile(0.5),
+                         (unsigned long long)histogram.Percentile(0.99),
+                         (unsigned long long)histogram.Percentile(0.999),
+                         (unsigned long long)histogram.Max);
+                text += line;
+            }
+        }
+        for (size_t idx = 0; idx < Channels.size(); ++idx)
+        {
+            snprintf(line, sizeof(line), "channel %-5u %12llu msgs %16llu bytes\n",
+                     Channels[idx].ChannelNo, (unsigned long long)Channels[idx].Messages,
+                     (unsigned long long)Channels[idx].Bytes);
+            text += line;
+        }
+        return text;
+    }
+};
+
+// @Class:   ProbeRegistry
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   进程内全部线程探针的登记表，线程首次记录时分配自己的 ThreadProbe 并无锁加入链表
+//           Snapshot 可由任意线程随时调用，不阻塞记录的线程；
+//           线程退出后其 ThreadProbe 保留，统计不丢失；为避免退出时仍在记录的线程访问已释放的内存，
+//           ThreadProbe 在进程结束前不释放
+class ProbeRegistry
+{
+public:
+    static ProbeRegistry& Instance()
+    {
+        static ProbeRegistry registry;
+        return registry;
+    }
+    ProbeRegistry(const ProbeRegistry&) = delete;
+    ProbeRegistry& operator=(const ProbeRegistry&) = delete;
+    // 当前线程的探针
+    ThreadProbe* Local()
+    {
+        static thread_local ThreadProbe* local = nullptr;
+        if (local == nullptr)
+        {
+            local = new ThreadProbe;
+            ThreadProbe* head = head_.load(std::memory_order_relaxed);
+            do
+            {
+                local->next_ = head;
+            } while (!head_.compare_exchange_weak(head, local, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+        }
+        return local;
+    }
+    // 合并全部线程的探针数据
+    void Snapshot(ProbeSnapshot* snapshot) const
+    {
+        snapshot->ThreadCount = 0;
+        snapshot->Types.clear();
+        snapshot->Channels.clear();
+        for (const ThreadProbe* probe = head_.load(std::memory_order_acquire); probe;
+             probe = probe->Next())
+        {
+            ++snapshot->ThreadCount;
+            for (uint32_t idx = 0; idx < kProbeMsgTypeSlots; ++idx)
+            {
+                uint32_t msg_type = probe->MsgTypeAt(idx);
+                if (msg_type == 0)
+                {
+                    continue;
+                }
+                ProbeTypeStats* stats = find_or_insert_type(snapshot, msg_type);
+                for (uint32_t stage = 0; stage < kProbeStageCount; ++stage)
+                {
+                    probe->HistogramAt(idx, (ProbeStage)stage).Load(&stats->Stages[stage]);
+                }
+            }
+            for (uint32_t idx = 0; idx < kProbeChannelSlots; ++idx)
+            {
+                ProbeChannelStats channel;
+                if (probe->ChannelAt(idx, &channel.ChannelNo, &channel.Bytes, &channel.Messages))
+                {
+                    add_channel(snapshot, channel);
+                }
+            }
+        }
+    }
+private:
+    ProbeRegistry() : head_(nullptr) {}
+
+    static ProbeTypeStats* find_or_insert_type(ProbeSnapshot* snapshot, uint32_t msg_type)
+    {
+        std::vector<ProbeTypeStats>& types = snapshot->Types;
+        size_t pos = 0;
+        while (pos < types.size() && types[pos].MsgType < msg_type) { ++pos; }
+        if (pos == types.size() || types[pos].MsgType != msg_type)
+        {
+            types.insert(types.begin() + pos, ProbeTypeStats());
+            types[pos].MsgType = msg_type;
+        }
+        return &types[pos];
+    }
+    static void add_channel(ProbeSnapshot* snapshot, const ProbeChannelStats& channel)
+    {
+        std::vector<ProbeChannelStats>& channels = snapshot->Channels;
+        size_t pos = 0;
+        while (pos < channels.size() && channels[pos].ChannelNo < channel.ChannelNo) { ++pos; }
+        if (pos < channels.size() && channels[pos].ChannelNo == channel.ChannelNo)
+        {
+            channels[pos].Bytes += channel.Bytes;
+            channels[pos].Messages += channel.Messages;
+        }
+        else
+        {
+            channels.insert(channels.begin() + pos, channel);
+        }
+    }
+
+    std::atomic<ThreadProbe*> head_;
+};
+
+// 报文类使用的探针，Enabled 为 false 时各函数为空，调用被完全消除
+template <bool Enabled>
+struct PacketProbe
+{
+    static inline uint64_t Now() { return 0; }
+    static inline void Structure(uint32_t, const char*, size_t, uint64_t, uint64_t, uint64_t) {}
+    static inline void GetField(uint32_t, uint64_t) {}
+};
+template <>
+struct PacketProbe<true>
+{
+    static inline uint64_t Now() { return ReadTSC(); }
+    // start、check_start、check_end 分别为 Structure 开始、校验和开始与结束时的计数
+    static inline void Structure(uint32_t msg_type, const char* body, size_t body_length,
+                                 uint64_t start, uint64_t check_start, uint64_t check_end)
+    {
+        uint64_t end = ReadTSC();
+        ThreadProbe* probe = ProbeRegistry::Instance().Local();
+        probe->Record(msg_type, kProbeStructure, end - start);
+        probe->Record(msg_type, kProbeCheckSum, check_end - check_start);
+        uint16_t channel_no = 0;
+        LoadChannelNo(msg_type, body, body_length, &channel_no);
+        // 报文头 8 字节，校验和 4 字节
+        probe->Count(channel_no, body_length + 12);
+    }
+    static inline void GetField(uint32_t msg_type, uint64_t start)
+    {
+        uint64_t end = ReadTSC();
+        ProbeRegistry::Instance().Local()->Record(msg_type, kProbeGetField, end - start);
+    }
+};
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_PROBE_H__
@@ -0,0 +1,473 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    回放抓取的 binary 字节流文件：映射文件后逐个结构化报文交给实盘使用的处理者，
+//            支持全速、按行情时间实时及按倍速回放，借助旁路索引按时间或 ApplSeqNum 定位
+
+#ifndef __CN_SZSE_BINARY_REPLAY_H__
+#define __CN_SZSE_BINARY_REPLAY_H__
+
+#include "szse_binary_dispatch.hpp"
+#include "szse_binary_file.hpp"
+#include "szse_binary_md_field.hpp"
+#include "szse_binary_packet.hpp"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+static const uint32_t kReplayIndexInterval = 4096;     // 默认每隔多少个报文记录一个索引项
+static const char kReplayIndexMagic[8] = { 'S', 'Z', 'S', 'E', 'I', 'D', 'X', '1' };
+
+// 索引项：Value 为 Offset 之前已出现的最大值，因此按 Value 单调，可二分查找
+struct ReplayIndexEntry
+{
+    uint64_t    Offset;         // 报文在文件中的偏移
+    int64_t     Value;          // 行情时间，或该频道的 ApplSeqNum
+    uint16_t    ChannelNo;      // 仅 ApplSeqNum 索引项有效
+    uint16_t    Kind;           // ReplayIndex::kTime 或 ReplayIndex::kApplSeqNum
+    uint32_t    Reserved;
+};
+
+// 索引文件头
+struct ReplayIndexHeader
+{
+    char        Magic[8];
+    uint32_t    Interval;
+    uint32_t    Reserved;
+    uint64_t    DataSize;       // 建立索引时的数据文件长度，用于判断索引是否过期
+    uint64_t    EntryCount;
+};
+
+// @Class:   ReplayIndex
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   稀疏索引：每 Interval 个报文记录一次此前的最大行情时间，
+//           每个频道每 Interval 条逐笔行情记录一次此前该频道的最大 ApplSeqNum
+//           查找返回的偏移不晚于第一个满足条件的报文，调用方从该处顺序扫描
+class ReplayIndex
+{
+public:
+    static const uint16_t kTime = 0;
+    static const uint16_t kApplSeqNum = 1;
+
+    ReplayIndex() : interval_(kReplayIndexInterval), data_size_(0) {}
+
+    // 扫描字节流建立索引，遇到不完整的报文时停止
+    void Build(const char* data, size_t size, uint32_t interval = kReplayIndexInterval)
+    {
+        interval_ = std::max<uint32_t>(interval, 1);
+        data_size_ = size;
+        time_entries_.clear();
+        seq_entries_.clear();
+        struct channel_counter
+        {
+            uint16_t channel_no;
+            uint64_t count;
+            int64_t max_seq;
+        };
+        std::vector<channel_counter> channels;
+        int64_t max_time = 0;
+        uint64_t packet_count = 0;
+        size_t offset = 0;
+        PacketRef ref;
+        size_t packet_size = 0;
+        while (frame(data, size, offset, &ref, &packet_size))
+        {
+            if (packet_count++ % interval_ == 0)
+            {
+                ReplayIndexEntry entry = { offset, max_time, 0, kTime, 0 };
+                time_entries_.push_back(entry);
+            }
+            int64_t msg_time = 0;
+            if (LoadMsgTime(ref.MsgType, ref.BodyAddr, ref.BodyLength, &msg_time))
+            {
+                max_time = std::max(max_time, msg_time);
+            }
+            uint16_t channel_no = 0;
+            int64_t seq = 0;
+            if (LoadApplSeqNum(ref.MsgType, ref.BodyAddr, ref.BodyLength, &channel_no, &seq))
+            {
+                size_t idx = 0;
+                while (idx < channels.size() && channels[idx].channel_no != channel_no) { ++idx; }
+                if (idx == channels.size())
+                {
+                    channel_counter counter = { channel_no, 0, 0 };
+                    channels.push_back(counter);
+                }
+                channel_counter& counter = channels[idx];
+                if (counter.count++ % interval_ == 0)
+                {
+                    ReplayIndexEntry entry = { offset, counter.max_seq, channel_no, kApplSeqNum, 0 };
+                    seq_entries_.push_back(entry);
+                }
+                counter.max_seq = std::max(counter.max_seq, seq);
+            }
+            offset += packet_size;
+        }
+        sort_seq_entries();
+    }
+    bool Save(const std::string& path) const
+    {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+        ReplayIndexHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.Magic, kReplayIndexMagic, sizeof(header.Magic));
+        header.Interval = interval_;
+        header.DataSize = data_size_;
+        header.EntryCount = time_entries_.size() + seq_entries_.size();
+        bool result = fwrite(&header, sizeof(header), 1, file) == 1
+            && fwrite(time_entries_.data(), sizeof(ReplayIndexEntry),
+                      time_entries_.size(), file) == time_entries_.size()
+            && fwrite(seq_entries_.data(), sizeof(ReplayIndexEntry),
+                      seq_entries_.size(), file) == seq_entries_.size();
+        return fclose(file) == 0 && result;
+    }
+    // 载入索引文件，data_size 与建立索引时不一致时视为过期，返回 false
+    bool Load(const std::string& path, uint64_t data_size)
+    {
+        MappedFile file;
+        if (!file.Open(path) || file.Size() < sizeof(ReplayIndexHeader))
+        {
+            return false;
+        }
+        const ReplayIndexHeader* header = (const ReplayIndexHeader*)file.Data();
+        if (memcmp(header->Magic, kReplayIndexMagic, sizeof(header->Magic)) != 0
+            || header->DataSize != data_size || header->Interval == 0
+            || (file.Size() - sizeof(ReplayIndexHeader)) / sizeof(ReplayIndexEntry)
+                < header->EntryCount)
+        {
+            return false;
+        }
+        interval_ = header->Interval;
+        data_size_ = header->DataSize;
+        time_entries_.clear();
+        seq_entries_.clear();
+        const ReplayIndexEntry* entries = (const ReplayIndexEntry*)(header + 1);
+        for (uint64_t idx = 0; idx < header->EntryCount; ++idx)
+        {
+            (entries[idx].Kind == kTime ? time_entries_ : seq_entries_).push_back(entries[idx]);
+        }
+        sort_seq_entries();
+        return true;
+    }
+
+    // 行情时间不早于 msg_time 的第一个报文之前的最近索引位置
+    uint64_t FindTime(int64_t msg_time) const
+    {
+        auto it = std::lower_bound(time_entries_.begin(), time_entries_.end(), msg_time,
+            [](const ReplayIndexEntry& entry, int64_t value) { return entry.Value < value; });
+        return it == time_entries_.begin() ? 0 : (it - 1)->Offset;
+    }
+    // 频道中 ApplSeqNum 不小于 appl_seq_num 的第一条逐笔行情之前的最近索引位置
+    uint64_t FindApplSeqNum(uint16_t channel_no, int64_t appl_seq_num) const
+    {
+        ReplayIndexEntry key = { 0, appl_seq_num, channel_no, kApplSeqNum, 0 };
+        auto it = std::lower_bound(seq_entries_.begin(), seq_entries_.end(), key,
+            [](const ReplayIndexEntry& lhs, const ReplayIndexEntry& rhs)
+            {
+                return lhs.ChannelNo != rhs.ChannelNo ? lhs.ChannelNo < rhs.ChannelNo
+                                                      : lhs.Value < rhs.Value;
+            });
+        if (it == seq_entries_.begin() || (it - 1)->ChannelNo != channel_no)
+        {
+            return 0;
+        }
+        return (it - 1)->Offset;
+    }
+    inline uint32_t Interval() const { return interval_; }
+    inline uint64_t DataSize() const { return data_size_; }
+    inline size_t Size() const { return time_entries_.size() + seq_entries_.size(); }
+
+    // 读取 offset 处的报文头，不校验校验和；报文不完整时返回 false
+    static bool frame(const char* data, size_t size, size_t offset,
+                      PacketRef* ref, size_t* packet_size)
+    {
+        static const size_t kHeaderSize = immutable_::MsgHeader::SSize;
+        static const size_t kCheckSumSize = sizeof(uint32_t);
+        if (offset > size || size - offset < kHeaderSize)
+        {
+            return false;
+        }
+        const char* addr = data + offset;
+        ref->MsgType = LoadBigEndian<uint32_t>(addr);
+        ref->BodyLength = LoadBigEndian<uint32_t>(addr + sizeof(uint32_t));
+        ref->BodyAddr = addr + kHeaderSize;
+        *packet_size = kHeaderSize + (size_t)ref->BodyLength + kCheckSumSize;
+        return size - offset >= *packet_size;
+    }
+private:
+    // ApplSeqNum 索引项按频道分组，组内按偏移即按 Value 有序
+    void sort_seq_entries()
+    {
+        std::stable_sort(seq_entries_.begin(), seq_entries_.end(),
+            [](const ReplayIndexEntry& lhs, const ReplayIndexEntry& rhs)
+            {
+                return lhs.ChannelNo < rhs.ChannelNo;
+            });
+    }
+
+    uint32_t interval_;
+    uint64_t data_size_;
+    std::vector<ReplayIndexEntry> time_entries_;
+    std::vector<ReplayIndexEntry> seq_entries_;
+};
+
+// 判断处理者能否直接接收 PacketRef
+template <typename Handler>
+struct is_packet_handler
+{
+private:
+    template <typename H>
+    static auto test(int) -> decltype(
+        std::declval<H&>()(std::declval<const PacketRef&>()), std::true_type());
+    template <typename H>
+    static std::false_type test(...);
+public:
+    static const bool value = decltype(test<Handler>(0))::value;
+};
+
+template <typename Handler>
+inline typename std::enable_if<is_packet_handler<Handler>::value>::type
+replay_packet(Handler& handler, const PacketRef& ref)
+{
+    handler(ref);
+}
+template <typename Handler>
+inline typename std::enable_if<!is_packet_handler<Handler>::value>::type
+replay_packet(Handler& handler, const PacketRef& ref)
+{
+    Dispatch(ref, handler);
+}
+
+// @Class:   BasicReplayer
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   文件为连续的 binary 报文（TCP 载荷），报文直接指向映射的文件，不拷贝
+//           Handler 提供 operator()(const PacketRef&) 时直接调用，否则作为访问者经 Dispatch 分发，
+//           因此 BasicGapTracker、BasicOrderBookEngine 等实盘组件可直接使用；
+//           Handler 可为引用类型，如 BasicReplayer<OrderBookEngine&>，以使用不可复制的处理者
+//           回放速度：
+//               0   全速（默认）
+//               1   按行情时间实时回放
+//               N   N 倍速
+//           行情时间回退时不等待；Stop 可由其他线程调用
+template <typename Handler, typename CheckSumPolicy = CheckSumVerify>
+class BasicReplayer
+{
+public:
+    explicit BasicReplayer(const Handler& handler = Handler(),
+                           const CheckSumPolicy& policy = CheckSumPolicy())
+        : handler_(handler), packet_(policy), position_(0), packet_count_(0),
+          error_(false), stop_(false), speed_(0), paced_(false), base_time_(0), last_time_(0)
+    {
+    }
+    BasicReplayer(const BasicReplayer&) = delete;
+    BasicReplayer& operator=(const BasicReplayer&) = delete;
+
+    // 打开抓取文件，旁路索引为 path + ".idx"，不存在或已过期时重新建立，save_index 为 true 时保存
+    bool Open(const std::string& path, bool save_index = true,
+              uint32_t index_interval = kReplayIndexInterval)
+    {
+        if (!file_.Open(path))
+        {
+            return false;
+        }
+        std::string index_path = path + ".idx";
+        if (!index_.Load(index_path, file_.Size()))
+        {
+            index_.Build(file_.Data(), file_.Size(), index_interval);
+            if (save_index)
+            {
+                index_.Save(index_path);
+            }
+        }
+        Rewind();
+        return true;
+    }
+    // 设置回放速度，0 为全速
+    void SetSpeed(double speed)
+    {
+        speed_ = std::max(speed, 0.0);
+        paced_ = false;
+    }
+
+    // 定位到行情时间（LocalTimeStamp）不早于 msg_time 的第一个报文，不存在时定位到文件末尾
+    bool SeekTime(int64_t msg_time)
+    {
+        return seek(index_.FindTime(msg_time),
+            [msg_time](const PacketRef& ref)
+            {
+                int64_t packet_time = 0;
+                return LoadMsgTime(ref.MsgType, ref.BodyAddr, ref.BodyLength, &packet_time)
+                    && packet_time >= msg_time;
+            });
+    }
+    // 定位到频道中 ApplSeqNum 不小于 appl_seq_num 的第一条逐笔行情，不存在时定位到文件末尾
+    bool SeekApplSeqNum(uint16_t channel_no, int64_t appl_seq_num)
+    {
+        return seek(index_.FindApplSeqNum(channel_no, appl_seq_num),
+            [channel_no, appl_seq_num](const PacketRef& ref)
+            {
+                uint16_t packet_channel = 0;
+                int64_t packet_seq = 0;
+                return LoadApplSeqNum(ref.MsgType, ref.BodyAddr, ref.BodyLength,
+                                      &packet_channel, &packet_seq)
+                    && packet_channel == channel_no && packet_seq >= appl_seq_num;
+            });
+    }
+    void Rewind()
+    {
+        position_ = 0;
+        error_ = false;
+        paced_ = false;
+    }
+
+    // 回放一个报文，到达文件末尾或报文错误时返回 false
+    bool Step()
+    {
+        if (position_ >= file_.Size())
+        {
+            return false;
+        }
+        size_t mem_size = file_.Size() - (size_t)position_;
+        if (!packet_.Structure(file_.Data() + position_, &mem_size))
+        {
+            error_ = true;
+            return false;
+        }
+        PacketRef ref;
+        ref.MsgType = packet_.GetHeader()->MsgType.get_value();
+        ref.BodyLength = packet_.GetHeader()->BodyLength.get_value();
+        ref.BodyAddr = packet_.FieldPos();
+        if (speed_ > 0)
+        {
+            pace(ref);
+        }
+        replay_packet(handler_, ref);
+        position_ += mem_size;
+        ++packet_count_;
+        return true;
+    }
+    // 连续回放至多 max_packets 个报文，返回实际回放的个数
+    size_t Run(size_t max_packets = (size_t)-1)
+    {
+        stop_.store(false, std::memory_order_relaxed);
+        size_t count = 0;
+        while (count < max_packets && !stop_.load(std::memory_order_relaxed) && Step())
+        {
+            ++count;
+        }
+        return count;
+    }
+    void Stop() { stop_.store(true, std::memory_order_relaxed); }
+
+    inline bool End() const { return position_ >= file_.Size(); }
+    // 遇到不完整或校验和错误的报文
+    inline bool Error() const { return error_; }
+    inline uint64_t Position() const { return position_; }
+    inline uint64_t Size() const { return file_.Size(); }
+    inline uint64_t PacketCount() const { return packet_count_; }
+    inline const ReplayIndex& Index() const { return index_; }
+    Handler& GetHandler() { return handler_; }
+private:
+    template <typename Predicate>
+    bool seek(uint64_t offset, Predicate predicate)
+    {
+        PacketRef ref;
+        size_t packet_size = 0;
+        while (ReplayIndex::frame(file_.Data(), file_.Size(), (size_t)offset, &ref, &packet_size))
+        {
+            if (predicate(ref))
+            {
+                position_ = offset;
+                error_ = false;
+                paced_ = false;
+                return true;
+            }
+            offset += packet_size;
+        }
+        position_ = file_.Size();
+        return false;
+    }
+    // 行情时间换算为当日毫秒数
+    static inline int64_t time_of_day_ms(int64_t msg_time)
+    {
+        return TimeStampNanosOfDay(msg_time) / 1000000;
+    }
+    void pace(const PacketRef& ref)
+    {
+        int64_t msg_time = 0;
+        if (!LoadMsgTime(ref.MsgType, ref.BodyAddr, ref.BodyLength, &msg_time))
+        {
+            return;
+        }
+        int64_t time_ms = time_of_day_ms(msg_time);
+        if (!paced_)
+        {
+            paced_ = true;
+            base_time_ = last_time_ = time_ms;
+            base_clock_ = std::chrono::steady_clock::now();
+            return;
+        }
+        if (time_ms <= last_time_)
+        {
+            return;
+        }
+        last_time_ = time_ms;
+        std::chrono::steady_clock::time_point target = base_clock_
+            + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double, std::milli>((time_ms - base_time_) / speed_));
+        // 分段等待，使 Stop 能及时生效
+        const std::chrono::milliseconds max_sleep(100);
+        for (;;)
+        {
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (now >= target || stop_.load(std::memory_order_relaxed))
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                target - now, max_sleep));
+        }
+    }
+
+    Handler handler_;
+    immutable_::BasicPacket<CheckSumPolicy> packet_;
+    MappedFile file_;
+    ReplayIndex index_;
+    uint64_t position_;
+    uint64_t packet_count_;
+    bool error_;
+    std::atomic<bool> stop_;
+    double speed_;
+    bool paced_;                        // 是否已确定回放的起始时刻
+    int64_t base_time_;                 // 起始报文的当日毫秒数
+    int64_t last_time_;                 // 已回放的最大当日毫秒数
+    std::chrono::steady_clock::time_point base_clock_;
+};
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_REPLAY_H__
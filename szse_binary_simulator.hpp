@@ -0,0 +1,731 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    本地交易所行情模拟器，以 TCP 提供与行情网关一致的 binary 行情流，
+//            用于无法连接交易所的环境下的联调、压力测试及延迟测试
+
+#ifndef __CN_SZSE_BINARY_SIMULATOR_H__
+#define __CN_SZSE_BINARY_SIMULATOR_H__
+
+// winsock2.h 须先于 windows.h 包含
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "szse_binary_file.hpp"
+#include "szse_binary_gap.hpp"
+#include "szse_binary_md_field.hpp"
+#include "szse_binary_packet.hpp"
+#include "szse_binary_stream.hpp"
+#include "szse_binary_synthetic.hpp"
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+static const uint32_t kHistorySlotSize = 128;       // 重传历史中每条记录的字节数
+static const uint8_t kResendStatusComplete = 1;     // 重传状态：完成
+static const uint8_t kResendStatusPartial = 2;      // 重传状态：部分完成
+static const uint8_t kResendStatusReject = 3;       // 重传状态：拒绝
+
+// 模拟器参数
+struct SimulatorOptions
+{
+    std::string     BindAddress;            // 监听地址
+    uint16_t        Port;                   // 监听端口，0 表示由系统分配
+    std::string     SenderCompID;           // 模拟器一方的代码，用于登录应答
+    int32_t         HeartBtInt;             // 心跳间隔（秒），客户端登录时指定的值优先
+    uint64_t        MessageRate;            // 每秒发送的行情报文条数，0 表示不限速
+    uint32_t        ChannelHeartbeatMs;     // 频道心跳间隔（毫秒）
+    uint32_t        HistorySize;            // 每个逐笔频道可重传的报文条数，向上取整为 2 的幂
+    uint32_t        SendBatchSize;          // 合并发送的字节数
+    uint32_t        LogonTimeoutMs;         // 连接后等待登录的时间（毫秒）
+
+    SimulatorOptions()
+        : BindAddress("127.0.0.1"), Port(9129), SenderCompID("SZSE_SIMULATOR"),
+          HeartBtInt(3), MessageRate(0), ChannelHeartbeatMs(1000), HistorySize(1 << 16),
+          SendBatchSize(64 << 10), LogonTimeoutMs(10000)
+    {
+    }
+};
+
+// @Class:   SyntheticSource
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   合成行情源，由 SyntheticGenerator 生成，count 为 0 时不结束
+//           报文在下次调用 Next 前有效
+class SyntheticSource
+{
+public:
+    explicit SyntheticSource(uint64_t count = 0, const SyntheticMix& mix = kRealisticMix,
+                             uint16_t channel_count = 4, uint64_t seed = 20261017)
+        : generator_(mix, seed, channel_count), count_(count), generated_(0)
+    {
+    }
+    bool Next(const char** packet_addr, size_t* packet_size)
+    {
+        if ((count_ != 0 && generated_ >= count_) || !generator_.Next(&packet_))
+        {
+            return false;
+        }
+        ++generated_;
+        *packet_addr = packet_.ToStream();
+        *packet_size = packet_.StreamSize();
+        return true;
+    }
+    inline uint64_t Generated() const { return generated_; }
+private:
+    SyntheticGenerator generator_;
+    mutable_::Packet packet_;
+    uint64_t count_;
+    uint64_t generated_;
+};
+
+// @Class:   CaptureSource
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   回放抓包文件的行情源，文件为连续的 binary 报文（TCP 载荷），与 BasicReplayer 相同
+//           文件中的会话消息（登录、注销、心跳、重传、频道心跳）由模拟器自行产生，因此跳过；
+//           报文直接指向映射的文件，不校验校验和，截断的尾部视为结束
+class CaptureSource
+{
+public:
+    CaptureSource() : position_(0) {}
+
+    bool Open(const std::string& path)
+    {
+        position_ = 0;
+        return file_.Open(path, true);
+    }
+    bool Next(const char** packet_addr, size_t* packet_size)
+    {
+        const size_t header_size = immutable_::MsgHeader::SSize;
+        while (position_ + header_size <= file_.Size())
+        {
+            const char* addr = file_.Data() + position_;
+            uint32_t msg_type = LoadBigEndian<uint32_t>(addr);
+            size_t size = header_size + LoadBigEndian<uint32_t>(addr + sizeof(uint32_t))
+                + sizeof(uint32_t);
+            if (size > file_.Size() - position_)
+            {
+                break;
+            }
+            position_ += size;
+            if (!is_session_msg(msg_type))
+            {
+                *packet_addr = addr;
+                *packet_size = size;
+                return true;
+            }
+        }
+        return false;
+    }
+    inline void Rewind() { position_ = 0; }
+    inline size_t Position() const { return position_; }
+    inline size_t Size() const { return file_.Size(); }
+private:
+    static bool is_session_msg(uint32_t msg_type)
+    {
+        return msg_type == immutable_::Logon::kMsgType
+            || msg_type == immutable_::Logout::kMsgType
+            || msg_type == immutable_::Heartbeat::kMsgType
+            || msg_type == immutable_::ReTransmit::kMsgType
+            || msg_type == immutable_::ChannelHeartbeat::kMsgType;
+    }
+
+    MappedFile file_;
+    size_t position_;
+};
+
+// @Class:   BasicExchangeSimulator
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   监听一个端口，每次 Serve 接受一个连接并按行情网关的方式服务：
+//               登录        客户端首条消息须为 Logon，以 Logon 应答，心跳间隔取客户端的值
+//               行情        依次发送 Source 产生的报文，MessageRate 为 0 时以最快速度发送，
+//                           报文合并为 SendBatchSize 字节后发送
+//               心跳        超过心跳间隔未发送数据时发送 Heartbeat；
+//                           每 ChannelHeartbeatMs 为各逐笔频道发送 ChannelHeartbeat，
+//                           行情源结束后 EndOfChannel 置位
+//               重传        应答逐笔行情的 ReTransmit，随后发送仍在重传历史中的报文；
+//                           每个逐笔频道保留最近 HistorySize 条，超出 kHistorySlotSize 的报文不保留
+//               注销        收到 Logout 时以 Logout 应答并结束
+//           行情源结束后会话保持，仍可重传，直至客户端注销或断开
+//           Source 提供 bool Next(const char** packet_addr, size_t* packet_size)，
+//           如 SyntheticSource、CaptureSource；Source 可为引用类型，如 BasicExchangeSimulator<CaptureSource&>
+//           Stop 可由其他线程调用，此后不再接受连接；其余函数须在同一线程调用
+template <typename Source>
+class BasicExchangeSimulator
+{
+#if defined(_WIN32)
+    typedef SOCKET socket_type;
+#else
+    typedef int socket_type;
+#endif
+    struct history_slot
+    {
+        int64_t     seq;                // 0 表示空
+        uint32_t    size;
+        uint32_t    reserved;
+    };
+    static const uint32_t kSlotPacketSize = kHistorySlotSize - sizeof(history_slot);
+    struct channel_state
+    {
+        uint16_t            channel_no;
+        int64_t             last_seq;
+        std::vector<char>   history;
+    };
+    typedef std::chrono::steady_clock clock_type;
+public:
+    // args 用于原地构造 Source，Source 为引用类型时传入被引用的对象
+    template <typename ...Args>
+    explicit BasicExchangeSimulator(const SimulatorOptions& options, Args&&... args)
+        : source_(std::forward<Args>(args)...), options_(options), history_size_(1),
+          listen_socket_(invalid_socket()), client_socket_(invalid_socket()), port_(0),
+          stop_(false), end_of_stream_(false), logged_out_(false), heart_bt_int_(0),
+          input_(64 << 10), sent_count_(0), sent_bytes_(0), retransmit_count_(0),
+          resent_count_(0)
+    {
+        while (history_size_ < options_.HistorySize) { history_size_ <<= 1; }
+#if defined(_WIN32)
+        WSADATA wsa_data;
+        wsa_started_ = WSAStartup(MAKEWORD(2, 2), &wsa_data) == 0;
+#endif
+    }
+    ~BasicExchangeSimulator()
+    {
+        close_socket(&client_socket_);
+        close_socket(&listen_socket_);
+#if defined(_WIN32)
+        if (wsa_started_)
+        {
+            WSACleanup();
+        }
+#endif
+    }
+    BasicExchangeSimulator(const BasicExchangeSimulator&) = delete;
+    BasicExchangeSimulator& operator=(const BasicExchangeSimulator&) = delete;
+
+    // 开始监听，Port 为 0 时实际端口由 Port() 取得
+    bool Listen()
+    {
+        close_socket(&listen_socket_);
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(options_.Port);
+        if (inet_pton(AF_INET, options_.BindAddress.c_str(), &addr.sin_addr) != 1)
+        {
+            return fail("invalid bind address");
+        }
+        listen_socket_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listen_socket_ == invalid_socket())
+        {
+            return fail("socket");
+        }
+        int reuse = 1;
+        setsockopt(listen_socket_, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+        socklen_t addr_size = sizeof(addr);
+        if (bind(listen_socket_, (const sockaddr*)&addr, sizeof(addr)) != 0
+            || listen(listen_socket_, 1) != 0
+            || getsockname(listen_socket_, (sockaddr*)&addr, &addr_size) != 0)
+        {
+            close_socket(&listen_socket_);
+            return fail("bind");
+        }
+        port_ = ntohs(addr.sin_port);
+        return true;
+    }
+    // 接受一个连接并服务，直至客户端注销或断开、或调用 Stop
+    // 输出：
+    //     bool     客户端注销或调用 Stop 时为 true，出错或客户端断开时为 false，原因见 Error
+    bool Serve()
+    {
+        error_.clear();
+        logged_out_ = false;
+        if (!accept_client())
+        {
+            return false;
+        }
+        bool result = run_session();
+        close_socket(&client_socket_);
+        return result;
+    }
+    // 结束 Serve，已登录时向客户端发送 Logout
+    inline void Stop() { stop_.store(true, std::memory_order_relaxed); }
+
+    inline uint16_t Port() const { return port_; }
+    inline const std::string& Error() const { return error_; }
+    // 行情源是否已结束
+    inline bool EndOfStream() const { return end_of_stream_; }
+    // 已发送的行情报文条数，不含会话消息及重传
+    inline uint64_t SentCount() const { return sent_count_; }
+    // 已发送的全部字节数
+    inline uint64_t SentBytes() const { return sent_bytes_; }
+    // 已应答的重传请求数，及重传的报文条数
+    inline uint64_t RetransmitCount() const { return retransmit_count_; }
+    inline uint64_t ResentCount() const { return resent_count_; }
+    inline Source& GetSource() { return source_; }
+private:
+#if defined(_WIN32)
+    static inline socket_type invalid_socket() { return INVALID_SOCKET; }
+    static inline int socket_error() { return WSAGetLastError(); }
+    static inline void close_socket(socket_type* sock)
+    {
+        if (*sock != INVALID_SOCKET)
+        {
+            closesocket(*sock);
+            *sock = INVALID_SOCKET;
+        }
+    }
+#else
+    static inline socket_type invalid_socket() { return -1; }
+    static inline int socket_error() { return errno; }
+    static inline void close_socket(socket_type* sock)
+    {
+        if (*sock >= 0)
+        {
+            close(*sock);
+            *sock = -1;
+        }
+    }
+#endif
+    bool fail(const char* what)
+    {
+        error_ = std::string(what) + " (" + std::to_string(socket_error()) + ")";
+        return false;
+    }
+    // 等待可读，返回 1 可读，0 超时，-1 出错
+    static int wait_readable(socket_type sock, long timeout_us)
+    {
+        fd_set read_set;
+        FD_ZERO(&read_set);
+        FD_SET(sock, &read_set);
+        timeval timeout;
+        timeout.tv_sec = timeout_us / 1000000;
+        timeout.tv_usec = timeout_us % 1000000;
+        int ready = select((int)sock + 1, &read_set, nullptr, nullptr, &timeout);
+        return ready > 0 ? 1 : ready;
+    }
+    bool accept_client()
+    {
+        if (listen_socket_ == invalid_socket())
+        {
+            error_ = "not listening";
+            return false;
+        }
+        while (!stop_.load(std::memory_order_relaxed))
+        {
+            int ready = wait_readable(listen_socket_, 100000);
+            if (ready < 0)
+            {
+                return fail("select");
+            }
+            if (ready == 0)
+            {
+                continue;
+            }
+            client_socket_ = accept(listen_socket_, nullptr, nullptr);
+            if (client_socket_ == invalid_socket())
+            {
+                return fail("accept");
+            }
+            int no_delay = 1;
+            setsockopt(client_socket_, IPPROTO_TCP, TCP_NODELAY,
+                       (const char*)&no_delay, sizeof(no_delay));
+            return true;
+        }
+        error_ = "stopped";
+        return false;
+    }
+
+    bool run_session()
+    {
+        input_.Reset();
+        send_buffer_.clear();
+        if (!wait_logon())
+        {
+            return false;
+        }
+        const clock_type::duration heartbeat_interval = std::chrono::seconds(heart_bt_int_);
+        const clock_type::duration channel_heartbeat_interval =
+            std::chrono::milliseconds(options_.ChannelHeartbeatMs);
+        clock_type::time_point start = clock_type::now();
+        clock_type::time_point last_send = start;
+        clock_type::time_point last_channel_heartbeat = start;
+        uint64_t produced = 0;
+        while (!stop_.load(std::memory_order_relaxed))
+        {
+            clock_type::time_point now = clock_type::now();
+            // 不限速时每次合并发送 SendBatchSize 字节，否则按已用时间计算可发送的条数
+            double elapsed = std::chrono::duration<double>(now - start).count();
+            uint64_t allowed = options_.MessageRate == 0
+                ? std::numeric_limits<uint64_t>::max()
+                : (uint64_t)(elapsed * (double)options_.MessageRate) + 1;
+            while (!end_of_stream_ && produced < allowed
+                   && send_buffer_.size() < options_.SendBatchSize)
+            {
+                const char* packet_addr = nullptr;
+                size_t packet_size = 0;
+                if (!source_.Next(&packet_addr, &packet_size))
+                {
+                    end_of_stream_ = true;
+                    break;
+                }
+                record(packet_addr, packet_size);
+                send_buffer_.insert(send_buffer_.end(), packet_addr, packet_addr + packet_size);
+                ++produced;
+                ++sent_count_;
+            }
+            if (now - last_channel_heartbeat >= channel_heartbeat_interval)
+            {
+                queue_channel_heartbeats();
+                last_channel_heartbeat = now;
+            }
+            if (send_buffer_.empty() && now - last_send >= heartbeat_interval)
+            {
+                mutable_::Heartbeat heartbeat;
+                queue(&heartbeat);
+            }
+            if (!send_buffer_.empty())
+            {
+                if (!flush())
+                {
+                    return false;
+                }
+                last_send = now;
+            }
+            // 处理客户端消息；已达到速率或行情源已结束时在此等待，至多 1 毫秒
+            long wait_us = 0;
+            if (end_of_stream_)
+            {
+                wait_us = 1000;
+            }
+            else if (produced >= allowed)
+            {
+                double due = (double)produced / (double)options_.MessageRate - elapsed;
+                wait_us = due <= 0 ? 0 : due >= 0.001 ? 1000 : (long)(due * 1e6);
+            }
+            int ready = wait_readable(client_socket_, wait_us);
+            if (ready < 0)
+            {
+                return fail("select");
+            }
+            if (ready > 0 && !receive())
+            {
+                return logged_out_;
+            }
+        }
+        mutable_::Logout logout;
+        logout.Text.set_value("simulator stopped");
+        queue(&logout);
+        flush();
+        return true;
+    }
+    bool wait_logon()
+    {
+        clock_type::time_point deadline = clock_type::now()
+            + std::chrono::milliseconds(options_.LogonTimeoutMs);
+        while (!stop_.load(std::memory_order_relaxed) && clock_type::now() < deadline)
+        {
+            int ready = wait_readable(client_socket_, 100000);
+            if (ready < 0)
+            {
+                return fail("select");
+            }
+            if (ready == 0)
+            {
+                continue;
+            }
+            if (!receive_bytes())
+            {
+                return false;
+            }
+            immutable_::Packet packet;
+            bool check_sum_error = false;
+            if (input_.Next(&packet, &check_sum_error))
+            {
+                immutable_::Logon logon;
+                if (packet.GetHeader()->MsgType.get_value() != immutable_::Logon::kMsgType
+                    || !packet.GetField(&logon))
+                {
+                    error_ = "first message is not logon";
+                    return false;
+                }
+                answer_logon(logon);
+                input_.Release();
+                return flush();
+            }
+            if (check_sum_error)
+            {
+                error_ = "check sum error";
+                return false;
+            }
+        }
+        error_ = "logon timeout";
+        return false;
+    }
+    void answer_logon(const immutable_::Logon& request)
+    {
+        mutable_::Logon logon;
+        logon.SenderCompID.set_value(options_.SenderCompID.c_str());
+        logon.TargetCompID.load(request.SenderCompID.c_str());
+        logon.DefaultApplVerID.load(request.DefaultApplVerID.c_str());
+        heart_bt_int_ = request.HeartBtInt.get_value() > 0
+            ? request.HeartBtInt.get_value() : options_.HeartBtInt;
+        logon.HeartBtInt.set_value(heart_bt_int_);
+        queue(&logon);
+    }
+    bool receive_bytes()
+    {
+        size_t writable = 0;
+        char* write_addr = input_.WriteAddr(&writable);
+        if (writable == 0)
+        {
+            error_ = "receive buffer overflow";
+            return false;
+        }
+        int received = (int)recv(client_socket_, write_addr, (int)writable, 0);
+        if (received <= 0)
+        {
+            if (received == 0)
+            {
+                error_ = "connection closed";
+                return false;
+            }
+            return fail("recv");
+        }
+        input_.Commit((size_t)received);
+        return true;
+    }
+    // 处理客户端消息，会话结束时返回 false
+    bool receive()
+    {
+        if (!receive_bytes())
+        {
+            return false;
+        }
+        immutable_::Packet packet;
+        bool check_sum_error = false;
+        while (input_.Next(&packet, &check_sum_error))
+        {
+            switch (packet.GetHeader()->MsgType.get_value())
+            {
+            case immutable_::Logout::kMsgType:
+            {
+                mutable_::Logout logout;
+                queue(&logout);
+                flush();
+                logged_out_ = true;
+                return false;
+            }
+            case immutable_::ReTransmit::kMsgType:
+                answer_retransmit(packet);
+                break;
+            default:
+                break;
+            }
+        }
+        input_.Release();
+        if (check_sum_error)
+        {
+            error_ = "check sum error";
+            return false;
+        }
+        return send_buffer_.empty() || flush();
+    }
+    void answer_retransmit(const immutable_::Packet& packet)
+    {
+        immutable_::ReTransmit request;
+        if (!packet.GetField(&request))
+        {
+            return;
+        }
+        ++retransmit_count_;
+        int64_t begin_seq = request.ApplBegSeqNum.get_value();
+        int64_t end_seq = request.ApplEndSeqNum.get_value();
+        mutable_::ReTransmit response;
+        response.ResendType.set_value(request.ResendType.get_value());
+        response.ChannelNo.set_value(request.ChannelNo.get_value());
+        response.ApplBegSeqNum.set_value(begin_seq);
+        response.ApplEndSeqNum.set_value(end_seq);
+        response.NewsID.load(request.NewsID.c_str());
+
+        typename std::unordered_map<uint16_t, channel_state>::iterator channel =
+            channels_.find(request.ChannelNo.get_value());
+        if (request.ResendType.get_value() != kResendTypeTick || channel == channels_.end()
+            || begin_seq <= 0 || end_seq < begin_seq)
+        {
+            response.ResendStatus.set_value(kResendStatusReject);
+            response.RejectText.set_value("invalid request");
+            queue(&response);
+            return;
+        }
+        // 应答先于重传的报文发送，先统计可重传的条数
+        int64_t last_seq = std::min(end_seq, channel->second.last_seq);
+        int64_t available = 0;
+        for (int64_t seq = begin_seq; seq <= last_seq; ++seq)
+        {
+            available += history_at(channel->second, seq) != nullptr;
+        }
+        response.ResendStatus.set_value(available == end_seq - begin_seq + 1
+            ? kResendStatusComplete : available > 0 ? kResendStatusPartial
+            : kResendStatusReject);
+        if (available == 0)
+        {
+            response.RejectText.set_value("not available");
+        }
+        queue(&response);
+        for (int64_t seq = begin_seq; seq <= last_seq; ++seq)
+        {
+            const history_slot* slot = history_at(channel->second, seq);
+            if (slot)
+            {
+                const char* packet_addr = (const char*)(slot + 1);
+                send_buffer_.insert(send_buffer_.end(), packet_addr, packet_addr + slot->size);
+                ++resent_count_;
+            }
+        }
+    }
+
+    // 逐笔报文记入所属频道的重传历史
+    void record(const char* packet_addr, size_t packet_size)
+    {
+        const size_t header_size = immutable_::MsgHeader::SSize;
+        uint16_t channel_no = 0;
+        int64_t seq = 0;
+        if (packet_size < header_size + sizeof(uint32_t)
+            || !LoadApplSeqNum(LoadBigEndian<uint32_t>(packet_addr), packet_addr + header_size,
+                               packet_size - header_size - sizeof(uint32_t), &channel_no, &seq)
+            || seq <= 0)
+        {
+            return;
+        }
+        channel_state& channel = channels_[channel_no];
+        if (channel.history.empty())
+        {
+            channel.channel_no = channel_no;
+            channel.last_seq = 0;
+            channel.history.assign((size_t)history_size_ * kHistorySlotSize, 0);
+        }
+        channel.last_seq = std::max(channel.last_seq, seq);
+        history_slot* slot = (history_slot*)&channel.history[
+            (size_t)(seq & (history_size_ - 1)) * kHistorySlotSize];
+        if (packet_size > kSlotPacketSize)
+        {
+            slot->seq = 0;
+            return;
+        }
+        slot->seq = seq;
+        slot->size = (uint32_t)packet_size;
+        memcpy(slot + 1, packet_addr, packet_size);
+    }
+    const history_slot* history_at(const channel_state& channel, int64_t seq) const
+    {
+        const history_slot* slot = (const history_slot*)&channel.history[
+            (size_t)(seq & (history_size_ - 1)) * kHistorySlotSize];
+        return slot->seq == seq ? slot : nullptr;
+    }
+    void queue_channel_heartbeats()
+    {
+        mutable_::ChannelHeartbeat heartbeat;
+        for (typename std::unordered_map<uint16_t, channel_state>::const_iterator it =
+             channels_.begin(); it != channels_.end(); ++it)
+        {
+            heartbeat.ChannelNo.set_value(it->second.channel_no);
+            heartbeat.ApplLastSeqNum.set_value(it->second.last_seq);
+            heartbeat.EndOfChannel.set_value(end_of_stream_);
+            queue(&heartbeat);
+        }
+    }
+    template <typename FieldType>
+    void queue(FieldType* field)
+    {
+        packet_.InsertField(field);
+        const char* packet_stream = packet_.ToStream();
+        send_buffer_.insert(send_buffer_.end(), packet_stream,
+                            packet_stream + packet_.StreamSize());
+    }
+    bool flush()
+    {
+#if defined(MSG_NOSIGNAL)
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        size_t offset = 0;
+        while (offset < send_buffer_.size())
+        {
+            int sent = (int)send(client_socket_, &send_buffer_[offset],
+                                 (int)(send_buffer_.size() - offset), flags);
+            if (sent <= 0)
+            {
+#if !defined(_WIN32)
+                if (sent < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+#endif
+                send_buffer_.clear();
+                return fail("send");
+            }
+            offset += (size_t)sent;
+        }
+        sent_bytes_ += send_buffer_.size();
+        send_buffer_.clear();
+        return true;
+    }
+
+    Source source_;
+    SimulatorOptions options_;
+    uint32_t history_size_;
+    socket_type listen_socket_;
+    socket_type client_socket_;
+    uint16_t port_;
+    std::atomic<bool> stop_;
+    bool end_of_stream_;
+    bool logged_out_;
+    int32_t heart_bt_int_;
+#if defined(_WIN32)
+    bool wsa_started_;
+#endif
+    std::string error_;
+    StreamReassembler input_;
+    mutable_::Packet packet_;                           // 会话消息
+    std::vector<char> send_buffer_;
+    std::unordered_map<uint16_t, channel_state> channels_;
+    uint64_t sent_count_;
+    uint64_t sent_bytes_;
+    uint64_t retransmit_count_;
+    uint64_t resent_count_;
+};
+typedef BasicExchangeSimulator<SyntheticSource> ExchangeSimulator;
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_SIMULATOR_H__
@@ -0,0 +1,317 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    集中竞价快照（300111）缓存，每个证券一条定长、按缓存行对齐的记录，
+//            直接从报文体原地更新，读线程通过顺序锁（seqlock）获得一致的副本
+
+#ifndef __CN_SZSE_BINARY_SNAPSHOT_H__
+#define __CN_SZSE_BINARY_SNAPSHOT_H__
+
+#include "szse_binary_md_field.hpp"
+#include "szse_binary_packet.hpp"
+#include "szse_binary_symbol.hpp"
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+static const size_t kSnapshotLevels = 10;       // 买卖盘档数
+static const size_t kSnapshotQueueSize = 50;    // 最优价位揭示的委托笔数
+
+// 快照价位，Price 放大 10^6（MDEntryPx），Qty 放大 10^2
+struct SnapshotLevel
+{
+    int64_t     Price;
+    int64_t     Qty;
+    int64_t     NumberOfOrders;
+};
+
+// 快照数据，价格除 PrevClosePx（放大 10^4）外均为 MDEntryPx 的精度（放大 10^6）
+struct SnapshotData
+{
+    char            SecurityID[8];          // 证券代码，右补空格
+    char            TradingPhaseCode[8];    // 交易阶段代码
+    uint16_t        ChannelNo;
+    int64_t         OrigTime;
+    int64_t         PrevClosePx;
+    int64_t         LastPx;                 // MDEntryType 2
+    int64_t         OpenPx;                 // MDEntryType 4
+    int64_t         HighPx;                 // MDEntryType 7
+    int64_t         LowPx;                  // MDEntryType 8
+    int64_t         UpperLimitPx;           // MDEntryType xe
+    int64_t         LowerLimitPx;           // MDEntryType xf
+    int64_t         NumTrades;
+    int64_t         TotalVolumeTrade;
+    int64_t         TotalValueTrade;
+    uint32_t        BidLevels;              // Bid 中的有效档数
+    uint32_t        AskLevels;
+    SnapshotLevel   Bid[kSnapshotLevels];   // Bid[0] 为买一
+    SnapshotLevel   Ask[kSnapshotLevels];
+    uint32_t        BidQueueSize;           // BidQueue 中的有效笔数
+    uint32_t        AskQueueSize;
+    int64_t         BidQueue[kSnapshotQueueSize];   // 买一揭示的委托数量
+    int64_t         AskQueue[kSnapshotQueueSize];
+};
+
+// 缓存记录，Sequence 为奇数时表示正在写入
+struct SnapshotRecord
+{
+    std::atomic<uint32_t>   Sequence;
+    SnapshotData            Data;
+};
+
+// @Class:   SnapshotCache
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   记录按 64 字节对齐、连续分配，创建后地址不变，容量在构造时确定
+//           证券代码经 SecurityTable 映射为记录下标，读线程可无锁查找
+//           Update 只能由一个写线程调用；Read 可由任意线程调用
+class SnapshotCache
+{
+    typedef immutable_::MarketSnapshot_300111 snapshot_type;
+    typedef snapshot_type::SecurityEntry entry_type;
+    // MarketSnapshotBase 与 NoMDEntries 的布局，由报文定义推导
+    typedef decltype(field_layout_of(
+        std::declval<snapshot_type&>().OrigTime, std::declval<snapshot_type&>().ChannelNo,
+        std::declval<snapshot_type&>().MDStreamID, std::declval<snapshot_type&>().SecurityID,
+        std::declval<snapshot_type&>().SecurityIDSource,
+        std::declval<snapshot_type&>().TradingPhaseCode,
+        std::declval<snapshot_type&>().PrevClosePx, std::declval<snapshot_type&>().NumTrades,
+        std::declval<snapshot_type&>().TotalVolumeTrade,
+        std::declval<snapshot_type&>().TotalValueTrade,
+        std::declval<snapshot_type&>().NoMDEntries)) head_layout;
+    // SecurityEntry 定长部分的布局
+    typedef decltype(field_layout_of(
+        std::declval<entry_type&>().MDEntryType, std::declval<entry_type&>().MDEntryPx,
+        std::declval<entry_type&>().MDEntrySize, std::declval<entry_type&>().MDPriceLevel,
+        std::declval<entry_type&>().NumberOfOrders,
+        std::declval<entry_type&>().NoOrders)) entry_layout;
+    static const size_t kOrderQtySize = sizeof(int64_t);
+public:
+    // capacity 为最多缓存的证券只数
+    explicit SnapshotCache(size_t capacity = 16384)
+        : securities_(capacity)
+    {
+        size_t record_size = sizeof(SnapshotRecord);
+        stride_ = (record_size + 63) / 64 * 64;
+        memory_.reset(new char[stride_ * capacity + 64]);
+        records_ = (char*)(((uintptr_t)memory_.get() + 63) & ~(uintptr_t)63);
+    }
+    ~SnapshotCache()
+    {
+        for (size_t idx = 0; idx < securities_.Size(); ++idx)
+        {
+            record_at(idx)->~SnapshotRecord();
+        }
+    }
+    SnapshotCache(const SnapshotCache&) = delete;
+    SnapshotCache& operator=(const SnapshotCache&) = delete;
+
+    // 由 300111 报文体更新，报文格式错误或容量不足时返回 false
+    bool Update(const char* body, size_t body_length)
+    {
+        uint32_t entry_count = 0;
+        if (!check(body, body_length, &entry_count))
+        {
+            return false;
+        }
+        SnapshotRecord* record = insert(body + head_layout::offset(3));
+        if (record == nullptr)
+        {
+            return false;
+        }
+        uint32_t sequence = record->Sequence.load(std::memory_order_relaxed);
+        record->Sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        write(&record->Data, body, entry_count);
+        record->Sequence.store(sequence + 2, std::memory_order_release);
+        return true;
+    }
+    bool Update(const PacketRef& ref)
+    {
+        return ref.MsgType == snapshot_type::kMsgType
+            && Update(ref.BodyAddr, ref.BodyLength);
+    }
+    // 证券代码（8 字节，右补空格）对应的记录，不存在时返回 nullptr
+    const SnapshotRecord* Find(const char* security_id) const
+    {
+        uint32_t index = securities_.Find(security_id);
+        return index == kInvalidSecurityIndex ? nullptr : record_at(index);
+    }
+    // 读取一致的副本，不存在时返回 false
+    bool Read(const char* security_id, SnapshotData* data) const
+    {
+        const SnapshotRecord* record = Find(security_id);
+        if (record == nullptr)
+        {
+            return false;
+        }
+        Read(*record, data);
+        return true;
+    }
+    static void Read(const SnapshotRecord& record, SnapshotData* data)
+    {
+        for (;;)
+        {
+            uint32_t before = record.Sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                continue;
+            }
+            memcpy(data, &record.Data, sizeof(SnapshotData));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (record.Sequence.load(std::memory_order_relaxed) == before)
+            {
+                return;
+            }
+        }
+    }
+    // 不经过缓存，直接将 300111 报文体解析为 SnapshotData
+    static bool Decode(const char* body, size_t body_length, SnapshotData* data)
+    {
+        uint32_t entry_count = 0;
+        if (!check(body, body_length, &entry_count))
+        {
+            return false;
+        }
+        memset(data, 0, sizeof(SnapshotData));
+        write(data, body, entry_count);
+        return true;
+    }
+    inline size_t Size() const { return securities_.Size(); }
+    inline size_t Capacity() const { return securities_.Capacity(); }
+    // 证券代码与记录下标的对应关系
+    inline const SecurityTable& Securities() const { return securities_; }
+private:
+    // 检查全部条目的长度，保证写入过程中不会失败
+    static bool check(const char* body, size_t body_length, uint32_t* entry_count)
+    {
+        if (body_length < head_layout::kSize)
+        {
+            return false;
+        }
+        *entry_count = LoadBigEndian<uint32_t>(body + head_layout::offset(10));
+        const char* entry = body + head_layout::kSize;
+        const char* body_end = body + body_length;
+        for (uint32_t idx = 0; idx < *entry_count; ++idx)
+        {
+            if ((size_t)(body_end - entry) < entry_layout::kSize)
+            {
+                return false;
+            }
+            uint32_t order_count = LoadBigEndian<uint32_t>(entry + entry_layout::offset(5));
+            size_t entry_size = entry_layout::kSize + order_count * kOrderQtySize;
+            if ((size_t)(body_end - entry) < entry_size)
+            {
+                return false;
+            }
+            entry += entry_size;
+        }
+        return true;
+    }
+    inline SnapshotRecord* record_at(size_t idx) const
+    {
+        return (SnapshotRecord*)(records_ + idx * stride_);
+    }
+    // 查找或创建记录，记录构造完成后才加入证券表
+    SnapshotRecord* insert(const char* security_id)
+    {
+        uint32_t index = securities_.Find(security_id);
+        if (index != kInvalidSecurityIndex)
+        {
+            return record_at(index);
+        }
+        if (securities_.Size() >= securities_.Capacity())
+        {
+            return nullptr;
+        }
+        SnapshotRecord* record = new (record_at(securities_.Size())) SnapshotRecord();
+        record->Sequence.store(0, std::memory_order_relaxed);
+        memset(&record->Data, 0, sizeof(SnapshotData));
+        return securities_.Intern(security_id) == kInvalidSecurityIndex ? nullptr : record;
+    }
+    static void write(SnapshotData* data, const char* body, uint32_t entry_count)
+    {
+        data->OrigTime = LoadBigEndian<int64_t>(body + head_layout::offset(0));
+        data->ChannelNo = LoadBigEndian<uint16_t>(body + head_layout::offset(1));
+        memcpy(data->SecurityID, body + head_layout::offset(3), sizeof(data->SecurityID));
+        memcpy(data->TradingPhaseCode, body + head_layout::offset(5),
+               sizeof(data->TradingPhaseCode));
+        data->PrevClosePx = LoadBigEndian<int64_t>(body + head_layout::offset(6));
+        data->NumTrades = LoadBigEndian<int64_t>(body + head_layout::offset(7));
+        data->TotalVolumeTrade = LoadBigEndian<int64_t>(body + head_layout::offset(8));
+        data->TotalValueTrade = LoadBigEndian<int64_t>(body + head_layout::offset(9));
+        data->BidLevels = data->AskLevels = 0;
+        data->BidQueueSize = data->AskQueueSize = 0;
+        const char* entry = body + head_layout::kSize;
+        for (uint32_t idx = 0; idx < entry_count; ++idx)
+        {
+            const char* type = entry + entry_layout::offset(0);
+            int64_t price = LoadBigEndian<int64_t>(entry + entry_layout::offset(1));
+            uint32_t order_count = LoadBigEndian<uint32_t>(entry + entry_layout::offset(5));
+            const char* order_qty = entry + entry_layout::kSize;
+            // MDEntryType 按 2 字节整数标签分派
+            uint16_t tag = LoadStringTag<2>(type);
+            switch (tag)
+            {
+            case StringTag<2>("0"):
+            case StringTag<2>("1"):
+            {
+                bool bid = tag == StringTag<2>("0");
+                uint16_t level = LoadBigEndian<uint16_t>(entry + entry_layout::offset(3));
+                if (level >= 1 && level <= kSnapshotLevels)
+                {
+                    SnapshotLevel& dst = bid ? data->Bid[level - 1] : data->Ask[level - 1];
+                    dst.Price = price;
+                    dst.Qty = LoadBigEndian<int64_t>(entry + entry_layout::offset(2));
+                    dst.NumberOfOrders = LoadBigEndian<int64_t>(entry + entry_layout::offset(4));
+                    uint32_t& levels = bid ? data->BidLevels : data->AskLevels;
+                    levels = std::max<uint32_t>(levels, level);
+                    if (level == 1)
+                    {
+                        uint32_t queue_size = std::min<uint32_t>(order_count,
+                                                                 kSnapshotQueueSize);
+                        int64_t* queue = bid ? data->BidQueue : data->AskQueue;
+                        for (uint32_t n = 0; n < queue_size; ++n)
+                        {
+                            queue[n] = LoadBigEndian<int64_t>(order_qty + n * kOrderQtySize);
+                        }
+                        (bid ? data->BidQueueSize : data->AskQueueSize) = queue_size;
+                    }
+                }
+                break;
+            }
+            case StringTag<2>("2"): data->LastPx = price; break;
+            case StringTag<2>("4"): data->OpenPx = price; break;
+            case StringTag<2>("7"): data->HighPx = price; break;
+            case StringTag<2>("8"): data->LowPx = price; break;
+            case StringTag<2>("xe"): data->UpperLimitPx = price; break;
+            case StringTag<2>("xf"): data->LowerLimitPx = price; break;
+            default: break;
+            }
+            entry += entry_layout::kSize + order_count * kOrderQtySize;
+        }
+    }
+
+    SecurityTable securities_;          // 证券下标即记录下标
+    size_t stride_;
+    std::unique_ptr<char[]> memory_;
+    char* records_;                     // 按 64 字节对齐
+};
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_SNAPSHOT_H__
@@ -0,0 +1,554 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    逐笔委托、逐笔成交与集中竞价快照的列式存储，每个数据域一个列文件，
+//            读取时映射文件，直接按数组扫描，不再经过报文解析
+
+#ifndef __CN_SZSE_BINARY_STORE_H__
+#define __CN_SZSE_BINARY_STORE_H__
+
+#include "szse_binary_file.hpp"
+#include "szse_binary_md_field.hpp"
+#include "szse_binary_packet.hpp"
+#include "szse_binary_snapshot.hpp"
+#include "szse_binary_symbol.hpp"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+// 列文件头，数据区从 kColumnHeaderSize 处开始，元素为本机字节序
+static const char kColumnMagic[8] = { 'S', 'Z', 'S', 'E', 'C', 'O', 'L', '1' };
+static const size_t kColumnHeaderSize = 64;
+
+struct ColumnHeader
+{
+    char        Magic[8];
+    uint32_t    ElementSize;        // 每个元素的字节数
+    char        Reserved[kColumnHeaderSize - 12];
+};
+
+// 列文件路径：<dir>/<table>.<column>.col
+inline std::string ColumnPath(const std::string& dir, const char* table, const char* column)
+{
+    return dir + "/" + table + "." + column + ".col";
+}
+
+// @Class:   ColumnWriter
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   按行追加一列，写满缓冲区后整块写入文件
+template <typename T>
+class ColumnWriter
+{
+    static const size_t kBufferRows = 8192;
+public:
+    ColumnWriter() : file_(nullptr), buffered_(0), rows_(0), failed_(false) {}
+    ~ColumnWriter() { Close(); }
+    ColumnWriter(const ColumnWriter&) = delete;
+    ColumnWriter& operator=(const ColumnWriter&) = delete;
+
+    // 创建列文件，已存在时覆盖
+    bool Open(const std::string& path)
+    {
+        Close();
+        file_ = fopen(path.c_str(), "wb");
+        if (file_ == nullptr)
+        {
+            return false;
+        }
+        ColumnHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.Magic, kColumnMagic, sizeof(header.Magic));
+        header.ElementSize = sizeof(T);
+        buffer_.reset(new T[kBufferRows]);
+        buffered_ = 0;
+        rows_ = 0;
+        failed_ = fwrite(&header, sizeof(header), 1, file_) != 1;
+        return !failed_;
+    }
+    // 列文件未打开或已关闭时忽略
+    inline void Append(T value)
+    {
+        if (SZSE_BINARY_UNLIKELY(file_ == nullptr))
+        {
+            return;
+        }
+        buffer_[buffered_++] = value;
+        ++rows_;
+        if (SZSE_BINARY_UNLIKELY(buffered_ == kBufferRows))
+        {
+            Flush();
+        }
+    }
+    // 写入缓冲区中的数据，此前有写入失败时返回 false
+    bool Flush()
+    {
+        if (file_ && buffered_ != 0)
+        {
+            failed_ |= fwrite(buffer_.get(), sizeof(T), buffered_, file_) != buffered_;
+            buffered_ = 0;
+        }
+        return !failed_;
+    }
+    bool Close()
+    {
+        bool result = Flush();
+        if (file_)
+        {
+            result = fclose(file_) == 0 && result;
+            file_ = nullptr;
+        }
+        return result;
+    }
+    inline uint64_t Rows() const { return rows_; }
+private:
+    FILE* file_;
+    std::unique_ptr<T[]> buffer_;
+    size_t buffered_;
+    uint64_t rows_;
+    bool failed_;
+};
+
+// @Class:   MappedColumn
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   只读映射一个列文件，Data<T>() 直接指向文件内容
+//           元素类型的大小与文件头不一致时 Data 返回 nullptr
+class MappedColumn
+{
+public:
+    MappedColumn() : rows_(0), element_size_(0) {}
+    explicit MappedColumn(const std::string& path) : rows_(0), element_size_(0)
+    {
+        Open(path);
+    }
+    MappedColumn(MappedColumn&& other)
+        : file_(std::move(other.file_)), rows_(other.rows_), element_size_(other.element_size_)
+    {
+        other.rows_ = 0;
+        other.element_size_ = 0;
+    }
+    MappedColumn& operator=(MappedColumn&& other)
+    {
+        if (this != &other)
+        {
+            file_ = std::move(other.file_);
+            rows_ = other.rows_;
+            element_size_ = other.element_size_;
+            other.rows_ = 0;
+            other.element_size_ = 0;
+        }
+        return *this;
+    }
+
+    bool Open(const std::string& path)
+    {
+        Close();
+        if (!file_.Open(path))
+        {
+            return false;
+        }
+        const ColumnHeader* header = (const ColumnHeader*)file_.Data();
+        if (file_.Size() < kColumnHeaderSize
+            || memcmp(header->Magic, kColumnMagic, sizeof(header->Magic)) != 0
+            || header->ElementSize == 0)
+        {
+            Close();
+            return false;
+        }
+        element_size_ = header->ElementSize;
+        rows_ = (file_.Size() - kColumnHeaderSize) / element_size_;
+        return true;
+    }
+    void Close()
+    {
+        file_.Close();
+        rows_ = 0;
+        element_size_ = 0;
+    }
+    inline bool Valid() const { return file_.Valid(); }
+    inline size_t Rows() const { return rows_; }
+    inline uint32_t ElementSize() const { return element_size_; }
+    template <typename T>
+    inline const T* Data() const
+    {
+        return file_.Valid() && sizeof(T) == element_size_
+            ? (const T*)(file_.Data() + kColumnHeaderSize) : nullptr;
+    }
+private:
+    MappedFile file_;
+    size_t rows_;
+    uint32_t element_size_;
+};
+
+// @Class:   TickStoreWriter
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   将 300192、300191 与 300111 写为列文件，价格与数量保存放大后的整数：
+//               order     SecurityIndex ChannelNo ApplSeqNum Price OrderQty Side OrdType OrderTime
+//               trade     SecurityIndex ChannelNo ApplSeqNum BidApplSeqNum OfferApplSeqNum
+//                         LastPx LastQty ExecType TransactTime
+//               snapshot  SecurityIndex ChannelNo OrigTime PrevClosePx NumTrades
+//                         TotalVolumeTrade TotalValueTrade LastPx OpenPx HighPx LowPx
+//                         UpperLimitPx LowerLimitPx BidPx1..10 BidQty1..10 AskPx1..10 AskQty1..10
+//               security  SecurityID，第 i 行为证券下标 i 的 8 字节代码，Close 时写入
+//           快照只保存前 10 档的价格与数量，缺失的档位为 0；其余消息类型忽略
+//           目录须已存在，其中的同名文件被覆盖；非线程安全
+class TickStoreWriter
+{
+    struct order_columns
+    {
+        ColumnWriter<uint32_t>  SecurityIndex;
+        ColumnWriter<uint16_t>  ChannelNo;
+        ColumnWriter<int64_t>   ApplSeqNum;
+        ColumnWriter<int64_t>   Price;
+        ColumnWriter<int64_t>   OrderQty;
+        ColumnWriter<char>      Side;
+        ColumnWriter<char>      OrdType;
+        ColumnWriter<int64_t>   OrderTime;
+    };
+    struct trade_columns
+    {
+        ColumnWriter<uint32_t>  SecurityIndex;
+        ColumnWriter<uint16_t>  ChannelNo;
+        ColumnWriter<int64_t>   ApplSeqNum;
+        ColumnWriter<int64_t>   BidApplSeqNum;
+        ColumnWriter<int64_t>   OfferApplSeqNum;
+        ColumnWriter<int64_t>   LastPx;
+        ColumnWriter<int64_t>   LastQty;
+        ColumnWriter<char>      ExecType;
+        ColumnWriter<int64_t>   TransactTime;
+    };
+    struct snapshot_columns
+    {
+        ColumnWriter<uint32_t>  SecurityIndex;
+        ColumnWriter<uint16_t>  ChannelNo;
+        ColumnWriter<int64_t>   OrigTime;
+        ColumnWriter<int64_t>   PrevClosePx;
+        ColumnWriter<int64_t>   NumTrades;
+        ColumnWriter<int64_t>   TotalVolumeTrade;
+        ColumnWriter<int64_t>   TotalValueTrade;
+        ColumnWriter<int64_t>   LastPx;
+        ColumnWriter<int64_t>   OpenPx;
+        ColumnWriter<int64_t>   HighPx;
+        ColumnWriter<int64_t>   LowPx;
+        ColumnWriter<int64_t>   UpperLimitPx;
+        ColumnWriter<int64_t>   LowerLimitPx;
+        ColumnWriter<int64_t>   BidPx[kSnapshotLevels];
+        ColumnWriter<int64_t>   BidQty[kSnapshotLevels];
+        ColumnWriter<int64_t>   AskPx[kSnapshotLevels];
+        ColumnWriter<int64_t>   AskQty[kSnapshotLevels];
+    };
+public:
+    // security_capacity 为最多容纳的证券只数
+    explicit TickStoreWriter(const std::string& dir, size_t security_capacity = 1 << 16)
+        : dir_(dir), securities_(security_capacity), valid_(false), closed_(false),
+          order_(new order_columns), trade_(new trade_columns),
+          snapshot_(new snapshot_columns)
+    {
+        valid_ = open_order() && open_trade() && open_snapshot();
+    }
+    ~TickStoreWriter() { Close(); }
+    TickStoreWriter(const TickStoreWriter&) = delete;
+    TickStoreWriter& operator=(const TickStoreWriter&) = delete;
+
+    // 全部列文件是否创建成功
+    inline bool Valid() const { return valid_; }
+
+    // 追加一个报文，消息类型不需要保存时返回 true，
+    // 解析失败、列文件未创建成功或已 Close 时返回 false
+    bool Append(const PacketRef& ref)
+    {
+        if (!writable())
+        {
+            return false;
+        }
+        switch (ref.MsgType)
+        {
+        case immutable_::OrderSnapshot_300192::kMsgType:
+            return order_field_.Load(ref.BodyAddr, ref.BodyLength) && Append(order_field_);
+        case immutable_::TransactionSnapshot_300191::kMsgType:
+            return trade_field_.Load(ref.BodyAddr, ref.BodyLength) && Append(trade_field_);
+        case immutable_::MarketSnapshot_300111::kMsgType:
+            return SnapshotCache::Decode(ref.BodyAddr, ref.BodyLength, &snapshot_data_)
+                && Append(snapshot_data_);
+        default:
+            return true;
+        }
+    }
+    bool Append(const immutable_::OrderSnapshot_300192& order)
+    {
+        if (!writable())
+        {
+            return false;
+        }
+        order_columns& columns = *order_;
+        columns.SecurityIndex.Append(intern(order.SecurityID.c_str()));
+        columns.ChannelNo.Append(order.ChannelNo.get_value());
+        columns.ApplSeqNum.Append(order.ApplSeqNum.get_value());
+        columns.Price.Append(order.Price.raw_value());
+        columns.OrderQty.Append(order.OrderQty.raw_value());
+        columns.Side.Append(order.Side.at(0));
+        columns.OrdType.Append(order.OrdType.at(0));
+        columns.OrderTime.Append(order.OrderTime.get_value());
+        return true;
+    }
+    bool Append(const immutable_::TransactionSnapshot_300191& trade)
+    {
+        if (!writable())
+        {
+            return false;
+        }
+        trade_columns& columns = *trade_;
+        columns.SecurityIndex.Append(intern(trade.SecurityID.c_str()));
+        columns.ChannelNo.Append(trade.ChannelNo.get_value());
+        columns.ApplSeqNum.Append(trade.ApplSeqNum.get_value());
+        columns.BidApplSeqNum.Append(trade.BidApplSeqNum.get_value());
+        columns.OfferApplSeqNum.Append(trade.OfferApplSeqNum.get_value());
+        columns.LastPx.Append(trade.LastPx.raw_value());
+        columns.LastQty.Append(trade.LastQty.raw_value());
+        columns.ExecType.Append(trade.ExecType.at(0));
+        columns.TransactTime.Append(trade.TransactTime.get_value());
+        return true;
+    }
+    bool Append(const SnapshotData& data)
+    {
+        if (!writable())
+        {
+            return false;
+        }
+        snapshot_columns& columns = *snapshot_;
+        columns.SecurityIndex.Append(intern(data.SecurityID));
+        columns.ChannelNo.Append(data.ChannelNo);
+        columns.OrigTime.Append(data.OrigTime);
+        columns.PrevClosePx.Append(data.PrevClosePx);
+        columns.NumTrades.Append(data.NumTrades);
+        columns.TotalVolumeTrade.Append(data.TotalVolumeTrade);
+        columns.TotalValueTrade.Append(data.TotalValueTrade);
+        columns.LastPx.Append(data.LastPx);
+        columns.OpenPx.Append(data.OpenPx);
+        columns.HighPx.Append(data.HighPx);
+        columns.LowPx.Append(data.LowPx);
+        columns.UpperLimitPx.Append(data.UpperLimitPx);
+        columns.LowerLimitPx.Append(data.LowerLimitPx);
+        for (uint32_t level = 0; level < kSnapshotLevels; ++level)
+        {
+            bool bid = level < data.BidLevels;
+            bool ask = level < data.AskLevels;
+            columns.BidPx[level].Append(bid ? data.Bid[level].Price : 0);
+            columns.BidQty[level].Append(bid ? data.Bid[level].Qty : 0);
+            columns.AskPx[level].Append(ask ? data.Ask[level].Price : 0);
+            columns.AskQty[level].Append(ask ? data.Ask[level].Qty : 0);
+        }
+        return true;
+    }
+
+    // 写入缓冲区中的数据，此前有写入失败时返回 false
+    bool Flush()
+    {
+        return for_each_column(flush_column()) && valid_;
+    }
+    // 写入证券代码表并关闭全部列文件，重复调用无效
+    bool Close()
+    {
+        if (closed_)
+        {
+            return valid_;
+        }
+        closed_ = true;
+        ColumnWriter<uint64_t> security_id;
+        bool result = security_id.Open(ColumnPath(dir_, "security", "SecurityID"));
+        for (uint32_t index = 0; index < securities_.Size(); ++index)
+        {
+            security_id.Append(securities_.KeyAt(index));
+        }
+        result = security_id.Close() && result;
+        valid_ = for_each_column(close_column()) && result && valid_;
+        return valid_;
+    }
+    inline uint64_t OrderRows() const { return order_->SecurityIndex.Rows(); }
+    inline uint64_t TradeRows() const { return trade_->SecurityIndex.Rows(); }
+    inline uint64_t SnapshotRows() const { return snapshot_->SecurityIndex.Rows(); }
+    inline const SecurityTable& Securities() const { return securities_; }
+private:
+    inline bool writable() const
+    {
+        return valid_ && !closed_;
+    }
+    inline uint32_t intern(const char* security_id)
+    {
+        return securities_.Intern(security_id);
+    }
+    template <typename T>
+    bool open(const char* table, const char* column, ColumnWriter<T>& writer)
+    {
+        return writer.Open(ColumnPath(dir_, table, column));
+    }
+    bool open_order()
+    {
+        order_columns& columns = *order_;
+        return open("order", "SecurityIndex", columns.SecurityIndex)
+            && open("order", "ChannelNo", columns.ChannelNo)
+            && open("order", "ApplSeqNum", columns.ApplSeqNum)
+            && open("order", "Price", columns.Price)
+            && open("order", "OrderQty", columns.OrderQty)
+            && open("order", "Side", columns.Side)
+            && open("order", "OrdType", columns.OrdType)
+            && open("order", "OrderTime", columns.OrderTime);
+    }
+    bool open_trade()
+    {
+        trade_columns& columns = *trade_;
+        return open("trade", "SecurityIndex", columns.SecurityIndex)
+            && open("trade", "ChannelNo", columns.ChannelNo)
+            && open("trade", "ApplSeqNum", columns.ApplSeqNum)
+            && open("trade", "BidApplSeqNum", columns.BidApplSeqNum)
+            && open("trade", "OfferApplSeqNum", columns.OfferApplSeqNum)
+            && open("trade", "LastPx", columns.LastPx)
+            && open("trade", "LastQty", columns.LastQty)
+            && open("trade", "ExecType", columns.ExecType)
+            && open("trade", "TransactTime", columns.TransactTime);
+    }
+    bool open_snapshot()
+    {
+        snapshot_columns& columns = *snapshot_;
+        bool result = open("snapshot", "SecurityIndex", columns.SecurityIndex)
+            && open("snapshot", "ChannelNo", columns.ChannelNo)
+            && open("snapshot", "OrigTime", columns.OrigTime)
+            && open("snapshot", "PrevClosePx", columns.PrevClosePx)
+            && open("snapshot", "NumTrades", columns.NumTrades)
+            && open("snapshot", "TotalVolumeTrade", columns.TotalVolumeTrade)
+            && open("snapshot", "TotalValueTrade", columns.TotalValueTrade)
+            && open("snapshot", "LastPx", columns.LastPx)
+            && open("snapshot", "OpenPx", columns.OpenPx)
+            && open("snapshot", "HighPx", columns.HighPx)
+            && open("snapshot", "LowPx", columns.LowPx)
+            && open("snapshot", "UpperLimitPx", columns.UpperLimitPx)
+            && open("snapshot", "LowerLimitPx", columns.LowerLimitPx);
+        for (uint32_t level = 0; result && level < kSnapshotLevels; ++level)
+        {
+            std::string suffix = std::to_string(level + 1);
+            result = open("snapshot", ("BidPx" + suffix).c_str(), columns.BidPx[level])
+                && open("snapshot", ("BidQty" + suffix).c_str(), columns.BidQty[level])
+                && open("snapshot", ("AskPx" + suffix).c_str(), columns.AskPx[level])
+                && open("snapshot", ("AskQty" + suffix).c_str(), columns.AskQty[level]);
+        }
+        return result;
+    }
+    struct flush_column
+    {
+        template <typename T>
+        bool operator()(ColumnWriter<T>& writer) const { return writer.Flush(); }
+    };
+    struct close_column
+    {
+        template <typename T>
+        bool operator()(ColumnWriter<T>& writer) const { return writer.Close(); }
+    };
+    // 对全部列调用 op，返回是否全部成功
+    template <typename Op>
+    bool for_each_column(Op op)
+    {
+        bool result = true;
+        order_columns& order = *order_;
+        result &= op(order.SecurityIndex) & op(order.ChannelNo) & op(order.ApplSeqNum)
+            & op(order.Price) & op(order.OrderQty) & op(order.Side) & op(order.OrdType)
+            & op(order.OrderTime);
+        trade_columns& trade = *trade_;
+        result &= op(trade.SecurityIndex) & op(trade.ChannelNo) & op(trade.ApplSeqNum)
+            & op(trade.BidApplSeqNum) & op(trade.OfferApplSeqNum) & op(trade.LastPx)
+            & op(trade.LastQty) & op(trade.ExecType) & op(trade.TransactTime);
+        snapshot_columns& snapshot = *snapshot_;
+        result &= op(snapshot.SecurityIndex) & op(snapshot.ChannelNo) & op(snapshot.OrigTime)
+            & op(snapshot.PrevClosePx) & op(snapshot.NumTrades)
+            & op(snapshot.TotalVolumeTrade) & op(snapshot.TotalValueTrade)
+            & op(snapshot.LastPx) & op(snapshot.OpenPx) & op(snapshot.HighPx)
+            & op(snapshot.LowPx) & op(snapshot.UpperLimitPx) & op(snapshot.LowerLimitPx);
+        for (uint32_t level = 0; level < kSnapshotLevels; ++level)
+        {
+            result &= op(snapshot.BidPx[level]) & op(snapshot.BidQty[level])
+                & op(snapshot.AskPx[level]) & op(snapshot.AskQty[level]);
+        }
+        return result;
+    }
+
+    std::string dir_;
+    SecurityTable securities_;
+    bool valid_;
+    bool closed_;
+    std::unique_ptr<order_columns> order_;
+    std::unique_ptr<trade_columns> trade_;
+    std::unique_ptr<snapshot_columns> snapshot_;
+    immutable_::OrderSnapshot_300192 order_field_;
+    immutable_::TransactionSnapshot_300191 trade_field_;
+    SnapshotData snapshot_data_;
+};
+
+// @Class:   TickStoreReader
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   读取 TickStoreWriter 写出的目录，Column 映射单个列文件，
+//           证券代码表在 Open 时载入，用于证券代码与 SecurityIndex 的互查
+class TickStoreReader
+{
+public:
+    TickStoreReader() {}
+    explicit TickStoreReader(const std::string& dir) { Open(dir); }
+
+    bool Open(const std::string& dir)
+    {
+        dir_ = dir;
+        securities_.reset();
+        MappedColumn column(ColumnPath(dir_, "security", "SecurityID"));
+        const uint64_t* keys = column.Data<uint64_t>();
+        if (keys == nullptr)
+        {
+            return false;
+        }
+        securities_.reset(new SecurityTable(column.Rows()));
+        for (size_t index = 0; index < column.Rows(); ++index)
+        {
+            securities_->Intern(keys[index]);
+        }
+        return true;
+    }
+    inline bool Valid() const { return securities_ != nullptr; }
+    // 映射 table 表的 column 列，失败时返回的列 Valid() 为 false
+    MappedColumn Column(const char* table, const char* column) const
+    {
+        return MappedColumn(ColumnPath(dir_, table, column));
+    }
+    // 证券代码（不足 8 字节时右补空格）对应的 SecurityIndex，不存在时为 kInvalidSecurityIndex
+    uint32_t SecurityIndex(const char* code) const
+    {
+        return securities_ ? securities_->Find(MakeSecurityKey(code))
+                           : kInvalidSecurityIndex;
+    }
+    // SecurityIndex 对应的证券代码，已去除右补的空格
+    std::string SecurityID(uint32_t index) const
+    {
+        return securities_ && index < securities_->Size()
+            ? securities_->SecurityIDAt(index) : std::string();
+    }
+    inline size_t SecurityCount() const { return securities_ ? securities_->Size() : 0; }
+private:
+    std::string dir_;
+    std::unique_ptr<SecurityTable> securities_;
+};
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_STORE_H__
@@ -0,0 +1,278 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    TCP 字节流重组，接收缓冲区为双重映射的环形缓冲区，
+//            跨越缓冲区末尾的报文在地址上仍然连续，结构化时不拷贝报文
+
+#ifndef __CN_SZSE_BINARY_STREAM_H__
+#define __CN_SZSE_BINARY_STREAM_H__
+
+#include "szse_binary_packet.hpp"
+
+#include <stdint.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+// @Class:   StreamReassembler
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   同一块物理内存被连续映射两次，[base, base + capacity) 与
+//           [base + capacity, base + 2 * capacity) 内容相同，
+//           因此任意位置起始、长度不超过 capacity 的区间都可以按连续内存访问
+//           使用方式：
+//               WriteAddr/Commit 直接将 recv 的数据写入缓冲区
+//               Next/NextBatch   结构化报文，报文指针直接指向缓冲区
+//               Release          批量释放已结构化的报文所占空间，此前报文指针均有效
+//           非线程安全，写入与结构化应在同一线程；capacity 须大于最大报文长度
+class StreamReassembler
+{
+public:
+    // capacity 向上取整为 2 的幂，且不小于系统的映射粒度
+    explicit StreamReassembler(size_t capacity = 4 << 20)
+        : base_(nullptr), capacity_(0), write_pos_(0), read_pos_(0), release_pos_(0)
+    {
+        size_t granularity = map_granularity();
+        size_t size = granularity;
+        while (size < capacity) { size <<= 1; }
+        if (map_mirror(size))
+        {
+            capacity_ = size;
+        }
+    }
+    ~StreamReassembler()
+    {
+        unmap_mirror();
+    }
+    StreamReassembler(const StreamReassembler&) = delete;
+    StreamReassembler& operator=(const StreamReassembler&) = delete;
+
+    // 映射是否成功
+    inline bool Valid() const { return base_ != nullptr; }
+    inline size_t Capacity() const { return capacity_; }
+    // 已写入、尚未结构化的字节数
+    inline size_t Readable() const { return (size_t)(write_pos_ - read_pos_); }
+    // 可写入的字节数
+    inline size_t Writable() const
+    {
+        return capacity_ - (size_t)(write_pos_ - release_pos_);
+    }
+
+    // 可写入的连续内存及其长度，写入后调用 Commit
+    inline char* WriteAddr(size_t* writable)
+    {
+        *writable = Writable();
+        return base_ + offset_of(write_pos_);
+    }
+    inline void Commit(size_t size)
+    {
+        assert(size <= Writable());
+        write_pos_ += size;
+    }
+    // 拷贝写入，返回实际写入的字节数
+    size_t Append(const char* mem_addr, size_t mem_size)
+    {
+        size_t writable = 0;
+        char* write_addr = WriteAddr(&writable);
+        size_t size = std::min(writable, mem_size);
+        memcpy(write_addr, mem_addr, size);
+        Commit(size);
+        return size;
+    }
+
+    // 结构化下一个报文，报文字节流直接指向缓冲区，在 Release 之前有效
+    // 返回 false 表示数据不完整，或 check_sum_error 非空时置为是否因报文错误失败；
+    // 报文错误为校验和错误，或 BodyLength 使报文超过 Capacity 而永远无法补齐，
+    // 错误的报文不会被跳过，调用方应重新建立连接并 Reset
+    template <typename CheckSumPolicy, bool Probe>
+    bool Next(immutable_::BasicPacket<CheckSumPolicy, Probe>* packet,
+              bool* check_sum_error = nullptr)
+    {
+        size_t readable = Readable();
+        if (check_sum_error)
+        {
+            *check_sum_error = false;
+        }
+        if (readable < immutable_::MsgHeader::SSize)
+        {
+            return false;
+        }
+        size_t mem_size = readable;
+        if (packet->Structure(base_ + offset_of(read_pos_), &mem_size))
+        {
+            read_pos_ += mem_size;
+            return true;
+        }
+        // 数据不完整时 mem_size 为所需长度，大于已有数据
+        if (check_sum_error)
+        {
+            *check_sum_error = mem_size <= readable || mem_size > capacity_;
+        }
+        return false;
+    }
+    // 批量结构化，参数与返回值的含义同 FrameBatch；
+    // 下一个报文超过 Capacity 时同样返回 false
+    template <typename CheckSumPolicy>
+    bool NextBatch(PacketRef* refs, size_t* ref_count, CheckSumPolicy& policy)
+    {
+        size_t readable = Readable();
+        size_t mem_size = readable;
+        bool result = FrameBatch(base_ + offset_of(read_pos_), &mem_size,
+                                 refs, ref_count, policy);
+        read_pos_ += readable - mem_size;
+        return result && !oversized(mem_size);
+    }
+    bool NextBatch(PacketRef* refs, size_t* ref_count)
+    {
+        CheckSumVerify policy;
+        return NextBatch(refs, ref_count, policy);
+    }
+    // 释放所有已结构化的报文，之后这些报文的指针失效
+    inline void Release() { release_pos_ = read_pos_; }
+    // 丢弃全部数据，用于重新建立连接
+    inline void Reset() { write_pos_ = read_pos_ = release_pos_ = 0; }
+
+private:
+    inline size_t offset_of(uint64_t pos) const
+    {
+        return (size_t)(pos & (capacity_ - 1));
+    }
+    // 剩余 readable 字节中的下一个报文是否超过 Capacity
+    inline bool oversized(size_t readable) const
+    {
+        if (readable < immutable_::MsgHeader::SSize)
+        {
+            return false;
+        }
+        uint32_t body_length = LoadBigEndian<uint32_t>(base_ + offset_of(read_pos_)
+                                                       + sizeof(uint32_t));
+        return immutable_::MsgHeader::SSize + (uint64_t)body_length + sizeof(uint32_t)
+            > capacity_;
+    }
+#if defined(_WIN32)
+    static size_t map_granularity()
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwAllocationGranularity;
+    }
+    bool map_mirror(size_t size)
+    {
+        HANDLE mapping = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFF), nullptr);
+        if (mapping == nullptr)
+        {
+            return false;
+        }
+        // 预留地址后释放再映射，期间地址可能被其他线程占用，因此重试
+        for (int retry = 0; retry < 16 && base_ == nullptr; ++retry)
+        {
+            char* addr = (char*)VirtualAlloc(nullptr, size * 2, MEM_RESERVE, PAGE_NOACCESS);
+            if (addr == nullptr)
+            {
+                break;
+            }
+            VirtualFree(addr, 0, MEM_RELEASE);
+            void* low = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, addr);
+            void* high = low ? MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0,
+                                               size, addr + size) : nullptr;
+            if (low && high)
+            {
+                base_ = addr;
+            }
+            else if (low)
+            {
+                UnmapViewOfFile(low);
+            }
+        }
+        CloseHandle(mapping);
+        return base_ != nullptr;
+    }
+    void unmap_mirror()
+    {
+        if (base_)
+        {
+            UnmapViewOfFile(base_);
+            UnmapViewOfFile(base_ + capacity_);
+            base_ = nullptr;
+        }
+    }
+#else
+    static size_t map_granularity()
+    {
+        return (size_t)sysconf(_SC_PAGESIZE);
+    }
+    bool map_mirror(size_t size)
+    {
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+        int fd = memfd_create("szse_binary_stream", MFD_CLOEXEC);
+#else
+        char path[] = "/tmp/szse_binary_stream_XXXXXX";
+        int fd = mkstemp(path);
+        if (fd >= 0)
+        {
+            unlink(path);
+        }
+#endif
+        if (fd < 0)
+        {
+            return false;
+        }
+        char* addr = nullptr;
+        if (ftruncate(fd, (off_t)size) == 0)
+        {
+            // 先预留两倍地址空间，再将同一文件覆盖映射到前后两半
+            void* reserve = mmap(nullptr, size * 2, PROT_NONE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (reserve != MAP_FAILED)
+            {
+                addr = (char*)reserve;
+                if (mmap(addr, size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED
+                    || mmap(addr + size, size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+                {
+                    munmap(addr, size * 2);
+                    addr = nullptr;
+                }
+            }
+        }
+        close(fd);
+        base_ = addr;
+        return base_ != nullptr;
+    }
+    void unmap_mirror()
+    {
+        if (base_)
+        {
+            munmap(base_, capacity_ * 2);
+            base_ = nullptr;
+        }
+    }
+#endif
+
+    char* base_;
+    size_t capacity_;
+    uint64_t write_pos_;    // 已写入位置
+    uint64_t read_pos_;     // 已结构化位置
+    uint64_t release_pos_;  // 已释放位置
+};
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_STREAM_H__
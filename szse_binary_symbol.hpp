@@ -0,0 +1,197 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    证券代码驻留，8 字节的 SecurityID 按 uint64_t 整体作为键，
+//            经开放寻址表映射为从 0 开始连续的证券下标，查找不分配内存
+
+#ifndef __CN_SZSE_BINARY_SYMBOL_H__
+#define __CN_SZSE_BINARY_SYMBOL_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+// 无效的证券下标
+static const uint32_t kInvalidSecurityIndex = 0xFFFFFFFF;
+
+// 报文中的证券代码（8 字节，右补空格）作为键
+inline uint64_t SecurityKey(const char* security_id)
+{
+    uint64_t key;
+    memcpy(&key, security_id, sizeof(key));
+    return key;
+}
+// 由不足 8 字节的代码构造键，如 "000001"
+inline uint64_t MakeSecurityKey(const char* code, size_t code_length)
+{
+    char security_id[8];
+    memset(security_id, ' ', sizeof(security_id));
+    memcpy(security_id, code, code_length < sizeof(security_id)
+                              ? code_length : sizeof(security_id));
+    return SecurityKey(security_id);
+}
+inline uint64_t MakeSecurityKey(const char* code)
+{
+    return MakeSecurityKey(code, strlen(code));
+}
+inline uint64_t MakeSecurityKey(const std::string& code)
+{
+    return MakeSecurityKey(code.data(), code.size());
+}
+
+// 报文中的证券代码源（4 字节，右补空格）作为键
+inline uint32_t SecurityIDSourceKey(const char* security_id_source)
+{
+    uint32_t key;
+    memcpy(&key, security_id_source, sizeof(key));
+    return key;
+}
+// 深圳证券交易所的证券代码源 "102 "
+static const char kSecurityIDSourceSZSE[] = "102 ";
+
+// @Class:   SecurityTable
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   证券代码到证券下标的开放寻址表，线性探测，只增不删，容量在构造时确定
+//           下标按加入顺序从 0 开始分配，可用于索引调用方的定长数组
+//           Intern 只能由一个写线程调用；Find 可由任意线程并发调用，
+//           写线程先写入下标再以 release 发布键，读线程以 acquire 读取键
+class SecurityTable
+{
+public:
+    // capacity 为最多容纳的证券只数，槽位数为其 2 倍以上，装载因子不超过 1/2
+    explicit SecurityTable(size_t capacity = 1 << 16)
+        : capacity_(capacity), size_(0), slot_bits_(4)
+    {
+        while (((size_t)1 << slot_bits_) < capacity * 2) { ++slot_bits_; }
+        size_t slot_count = (size_t)1 << slot_bits_;
+        slot_keys_.reset(new std::atomic<uint64_t>[slot_count]);
+        slot_indexes_.reset(new uint32_t[slot_count]);
+        keys_.reset(new uint64_t[capacity_]);
+        for (size_t idx = 0; idx < slot_count; ++idx)
+        {
+            slot_keys_[idx].store(0, std::memory_order_relaxed);
+        }
+    }
+    SecurityTable(const SecurityTable&) = delete;
+    SecurityTable& operator=(const SecurityTable&) = delete;
+
+    // 查找证券下标，不存在时返回 kInvalidSecurityIndex
+    inline uint32_t Find(uint64_t key) const
+    {
+        size_t mask = ((size_t)1 << slot_bits_) - 1;
+        for (size_t pos = slot_of(key); ; pos = (pos + 1) & mask)
+        {
+            uint64_t slot_key = slot_keys_[pos].load(std::memory_order_acquire);
+            if (slot_key == key)
+            {
+                return slot_indexes_[pos];
+            }
+            if (slot_key == 0)
+            {
+                return kInvalidSecurityIndex;
+            }
+        }
+    }
+    inline uint32_t Find(const char* security_id) const
+    {
+        return Find(SecurityKey(security_id));
+    }
+    // 查找证券下标，不存在时加入；键为 0 或容量已满时返回 kInvalidSecurityIndex
+    uint32_t Intern(uint64_t key)
+    {
+        if (key == 0)
+        {
+            return kInvalidSecurityIndex;
+        }
+        size_t mask = ((size_t)1 << slot_bits_) - 1;
+        size_t pos = slot_of(key);
+        for (;; pos = (pos + 1) & mask)
+        {
+            uint64_t slot_key = slot_keys_[pos].load(std::memory_order_relaxed);
+            if (slot_key == key)
+            {
+                return slot_indexes_[pos];
+            }
+            if (slot_key == 0)
+            {
+                break;
+            }
+        }
+        if (size_ >= capacity_)
+        {
+            return kInvalidSecurityIndex;
+        }
+        uint32_t index = (uint32_t)size_;
+        keys_[index] = key;
+        slot_indexes_[pos] = index;
+        size_ = size_ + 1;
+        slot_keys_[pos].store(key, std::memory_order_release);
+        return index;
+    }
+    inline uint32_t Intern(const char* security_id)
+    {
+        return Intern(SecurityKey(security_id));
+    }
+    // 由当日证券列表预先建立，代码不足 8 字节时右补空格，返回成功加入的只数
+    template <typename Iterator>
+    size_t Build(Iterator first, Iterator last)
+    {
+        size_t count = 0;
+        for (; first != last; ++first)
+        {
+            if (Intern(MakeSecurityKey(*first)) != kInvalidSecurityIndex)
+            {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    // 证券下标对应的键
+    inline uint64_t KeyAt(uint32_t index) const { return keys_[index]; }
+    // 证券下标对应的代码，已去除右补的空格
+    std::string SecurityIDAt(uint32_t index) const
+    {
+        const char* security_id = (const char*)&keys_[index];
+        size_t length = sizeof(uint64_t);
+        while (length > 0 && security_id[length - 1] == ' ') { --length; }
+        return std::string(security_id, length);
+    }
+    inline size_t Size() const { return size_; }
+    inline size_t Capacity() const { return capacity_; }
+private:
+    inline size_t slot_of(uint64_t key) const
+    {
+        return (size_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - slot_bits_));
+    }
+
+    size_t capacity_;
+    size_t size_;
+    uint32_t slot_bits_;
+    std::unique_ptr<std::atomic<uint64_t>[]> slot_keys_;    // 0 表示空位
+    std::unique_ptr<uint32_t[]> slot_indexes_;
+    std::unique_ptr<uint64_t[]> keys_;                      // 下标到键
+};
+
+// 进程内默认的证券表，各报文的 security_index() 在其中查找
+inline SecurityTable& DefaultSecurityTable()
+{
+    static SecurityTable table;
+    return table;
+}
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_SYMBOL_H__
@@ -0,0 +1,280 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    合成行情，按接近实盘的比例生成 300192/300191/300111/309011 报文，
+//            供基准测试与交易所模拟器使用
+
+#ifndef __CN_SZSE_BINARY_SYNTHETIC_H__
+#define __CN_SZSE_BINARY_SYNTHETIC_H__
+
+#include "szse_binary_md_field.hpp"
+#include "szse_binary_packet.hpp"
+#include "szse_binary_symbol.hpp"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+// 各消息类型所占的权重
+struct SyntheticMix
+{
+    uint32_t Order;         // 300192 逐笔委托
+    uint32_t Trade;         // 300191 逐笔成交
+    uint32_t Snapshot;      // 300111 集中竞价快照
+    uint32_t Index;         // 309011 指数快照
+};
+
+// 实盘中逐笔约占九成，快照约一成，指数快照很少
+static const SyntheticMix kRealisticMix = { 48, 40, 10, 2 };
+
+// @Class:   SyntheticGenerator
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   以 mutable_::Packet::InsertField 生成合成行情，固定种子时结果可复现
+//           证券按代码分配到频道：逐笔频道自 2011、快照频道自 1011 起连续编号，
+//           指数快照使用频道 1021；逐笔的 ApplSeqNum 在各频道内从 1 连续递增
+//           价格按 0.01 元随机游走，数量以 100 股为单位，快照为十档买卖盘，
+//           少数证券档位不满，买一、卖一揭示 0~50 笔委托，行情时间自 09:30:00.000 起
+class SyntheticGenerator
+{
+public:
+    explicit SyntheticGenerator(const SyntheticMix& mix = kRealisticMix,
+                                uint64_t seed = 20261017, uint16_t channel_count = 4,
+                                size_t security_count = 2000)
+        : mix_(mix), rng_(seed), channel_count_(channel_count ? channel_count : 1),
+          appl_seq_num_(channel_count_, 0), time_of_day_(34200000), time_(0), packet_(4096)
+    {
+        char code[16];
+        for (size_t idx = 0; idx < security_count; ++idx)
+        {
+            // 主板、中小板、创业板代码
+            static const int kPrefix[] = { 0, 2000, 300000 };
+            snprintf(code, sizeof(code), "%06d", kPrefix[idx % 3] + (int)(idx / 3) + 1);
+            securities_.push_back(code);
+            prices_.push_back(uniform(300, 20000) * 100);       // 3.00 ~ 200.00 元，乘数 10000
+        }
+    }
+
+    // 生成下一条报文写入 packet
+    bool Next(mutable_::Packet* packet)
+    {
+        advance_time();
+        uint32_t total = mix_.Order + mix_.Trade + mix_.Snapshot + mix_.Index;
+        uint32_t pick = total ? (uint32_t)uniform(0, total - 1) : 0;
+        if (pick < mix_.Order)
+        {
+            return packet->InsertField(make_order());
+        }
+        if (pick < mix_.Order + mix_.Trade)
+        {
+            return packet->InsertField(make_trade());
+        }
+        if (pick < mix_.Order + mix_.Trade + mix_.Snapshot)
+        {
+            return packet->InsertField(make_snapshot());
+        }
+        return packet->InsertField(make_index());
+    }
+    // 生成 count 条报文追加到 stream 尾部，返回生成的条数
+    size_t Generate(size_t count, std::vector<char>* stream)
+    {
+        size_t generated = 0;
+        for (; generated < count && Next(&packet_); ++generated)
+        {
+            const char* packet_stream = packet_.ToStream();
+            stream->insert(stream->end(), packet_stream, packet_stream + packet_.StreamSize());
+        }
+        return generated;
+    }
+
+    inline uint16_t ChannelCount() const { return channel_count_; }
+    // 生成报文所用的证券代码，各证券等概率出现
+    inline size_t SecurityCount() const { return securities_.size(); }
+    inline const std::string& SecurityAt(size_t idx) const { return securities_[idx]; }
+    // 逐笔频道已生成的最大 ApplSeqNum
+    inline int64_t LastApplSeqNum(uint16_t channel_no) const
+    {
+        return channel_no >= kTickChannelBase && channel_no < kTickChannelBase + channel_count_
+            ? appl_seq_num_[channel_no - kTickChannelBase] : 0;
+    }
+
+    static const uint16_t kTickChannelBase = 2011;
+    static const uint16_t kSnapshotChannelBase = 1011;
+    static const uint16_t kIndexChannel = 1021;
+private:
+    inline int64_t uniform(int64_t low, int64_t high)
+    {
+        return std::uniform_int_distribution<int64_t>(low, high)(rng_);
+    }
+    // 每条报文推进 0~2 毫秒
+    void advance_time()
+    {
+        time_of_day_ += uniform(0, 2);
+        int64_t seconds = time_of_day_ / 1000;
+        time_ = 20261017000000000LL + seconds / 3600 * 10000000 + seconds / 60 % 60 * 100000
+            + seconds % 60 * 1000 + time_of_day_ % 1000;
+    }
+    // 价格按 0.01 元随机游走
+    int64_t walk_price(size_t security)
+    {
+        int64_t price = prices_[security] + uniform(-2, 2) * 100;
+        prices_[security] = price < 100 ? 100 : price;
+        return prices_[security];
+    }
+    // 逐笔数量以 100 股为单位，乘数 100
+    int64_t lot_qty()
+    {
+        return uniform(1, 50) * 100 * 100;
+    }
+    inline size_t pick_security()
+    {
+        return (size_t)uniform(0, (int64_t)securities_.size() - 1);
+    }
+
+    mutable_::OrderSnapshot_300192* make_order()
+    {
+        size_t security = pick_security();
+        uint16_t channel = (uint16_t)(security % channel_count_);
+        order_.ChannelNo.set_value(kTickChannelBase + channel);
+        order_.ApplSeqNum.set_value(++appl_seq_num_[channel]);
+        order_.MDStreamID.set_value("011");
+        order_.SecurityID.set_value(securities_[security].c_str());
+        order_.SecurityIDSource.set_value(kSecurityIDSourceSZSE);
+        order_.Price.set_raw_value(walk_price(security));
+        order_.OrderQty.set_raw_value(lot_qty());
+        order_.Side.set_value(uniform(0, 1) ? "1" : "2");
+        order_.OrderTime.set_value(time_);
+        order_.OrdType.set_value(uniform(0, 19) ? "2" : "1");
+        return &order_;
+    }
+    // 约一成为撤单
+    mutable_::TransactionSnapshot_300191* make_trade()
+    {
+        size_t security = pick_security();
+        uint16_t channel = (uint16_t)(security % channel_count_);
+        int64_t seq = ++appl_seq_num_[channel];
+        bool cancel = uniform(0, 9) == 0;
+        trade_.ChannelNo.set_value(kTickChannelBase + channel);
+        trade_.ApplSeqNum.set_value(seq);
+        trade_.MDStreamID.set_value("011");
+        trade_.BidApplSeqNum.set_value(seq > 2 ? uniform(1, seq - 1) : 0);
+        trade_.OfferApplSeqNum.set_value(cancel ? 0 : (seq > 2 ? uniform(1, seq - 1) : 0));
+        trade_.SecurityID.set_value(securities_[security].c_str());
+        trade_.SecurityIDSource.set_value(kSecurityIDSourceSZSE);
+        trade_.LastPx.set_raw_value(cancel ? 0 : walk_price(security));
+        trade_.LastQty.set_raw_value(lot_qty());
+        trade_.ExecType.set_value(cancel ? "4" : "F");
+        trade_.TransactTime.set_value(time_);
+        return &trade_;
+    }
+    // 最新价、开盘价、最高价、最低价、涨停价、跌停价六个条目，及买卖盘
+    mutable_::MarketSnapshot_300111* make_snapshot()
+    {
+        size_t security = pick_security();
+        int64_t last_px = walk_price(security);
+        fill_snapshot_base(&snapshot_, security,
+                           kSnapshotChannelBase + (uint16_t)(security % channel_count_), "010");
+        snapshot_.SecurityEntryArray.clear();
+        static const char* kStatTypes[] = { "2 ", "4 ", "7 ", "8 ", "xe", "xf" };
+        for (size_t idx = 0; idx < sizeof(kStatTypes) / sizeof(kStatTypes[0]); ++idx)
+        {
+            mutable_::MarketSnapshot_300111::SecurityEntry* entry =
+                snapshot_.SecurityEntryArray.Append();
+            entry->MDEntryType.set_value(kStatTypes[idx]);
+            entry->MDEntryPx.set_value(last_px * 100 + uniform(-500, 500) * 100);
+            entry->MDEntrySize.set_raw_value(0);
+            entry->MDPriceLevel.set_value(0);
+            entry->NumberOfOrders.set_value(0);
+            entry->NoOrders.set_value(0);
+            entry->OrderQtyArray.clear();
+        }
+        uint16_t levels = uniform(0, 9) ? 10 : (uint16_t)uniform(1, 9);
+        for (int side = 0; side < 2; ++side)
+        {
+            for (uint16_t level = 1; level <= levels; ++level)
+            {
+                mutable_::MarketSnapshot_300111::SecurityEntry* entry =
+                    snapshot_.SecurityEntryArray.Append();
+                int64_t tick = (side == 0 ? -(int64_t)level : (int64_t)level) * 100;
+                entry->MDEntryType.set_value(side == 0 ? "0 " : "1 ");
+                entry->MDEntryPx.set_value((last_px + tick) * 100);
+                entry->MDEntrySize.set_raw_value(lot_qty() * uniform(1, 200));
+                entry->MDPriceLevel.set_value(level);
+                entry->NumberOfOrders.set_value(uniform(1, 500));
+                uint32_t queue_size = level == 1 ? (uint32_t)uniform(0, 50) : 0;
+                entry->NoOrders.set_value(queue_size);
+                entry->OrderQtyArray.clear();
+                for (uint32_t pos = 0; pos < queue_size; ++pos)
+                {
+                    entry->OrderQtyArray.Append()->Qty.set_raw_value(lot_qty());
+                }
+            }
+        }
+        snapshot_.NoMDEntries.set_value((uint32_t)snapshot_.SecurityEntryArray.count());
+        return &snapshot_;
+    }
+    // 当前点位、昨收、开盘、最高、最低五个条目
+    mutable_::MarketSnapshot_309011* make_index()
+    {
+        size_t security = (size_t)uniform(0, 99);
+        fill_snapshot_base(&index_, security, kIndexChannel, "900");
+        char code[16];
+        snprintf(code, sizeof(code), "399%03d", (int)security + 1);
+        index_.SecurityID.set_value(code);
+        index_.IndexEntryArray.clear();
+        static const char* kIndexTypes[] = { "3 ", "xa", "xb", "xc", "xd" };
+        int64_t point = uniform(1000, 15000) * 1000000LL;
+        for (size_t idx = 0; idx < sizeof(kIndexTypes) / sizeof(kIndexTypes[0]); ++idx)
+        {
+            mutable_::MarketSnapshot_309011::IndexEntry* entry = index_.IndexEntryArray.Append();
+            entry->MDEntryType.set_value(kIndexTypes[idx]);
+            entry->MDEntryPx.set_value(point + uniform(-50000000, 50000000));
+        }
+        index_.NoMDEntries.set_value((uint32_t)index_.IndexEntryArray.count());
+        return &index_;
+    }
+    template <typename SnapshotType>
+    void fill_snapshot_base(SnapshotType* snapshot, size_t security, uint16_t channel,
+                            const char* stream_id)
+    {
+        snapshot->OrigTime.set_value(time_);
+        snapshot->ChannelNo.set_value(channel);
+        snapshot->MDStreamID.set_value(stream_id);
+        snapshot->SecurityID.set_value(securities_[security % securities_.size()].c_str());
+        snapshot->SecurityIDSource.set_value(kSecurityIDSourceSZSE);
+        snapshot->TradingPhaseCode.set_value("T0      ");
+        snapshot->PrevClosePx.set_raw_value(prices_[security % prices_.size()]);
+        snapshot->NumTrades.set_value(uniform(0, 100000));
+        snapshot->TotalVolumeTrade.set_raw_value(uniform(0, 1000000000));
+        snapshot->TotalValueTrade.set_raw_value(uniform(0, 1000000000000LL));
+    }
+
+    SyntheticMix mix_;
+    std::mt19937_64 rng_;
+    uint16_t channel_count_;
+    std::vector<int64_t> appl_seq_num_;     // 各逐笔频道的 ApplSeqNum
+    int64_t time_of_day_;                   // 当日毫秒数
+    int64_t time_;                          // LocalTimeStamp，YYYYMMDDHHMMSSsss
+    std::vector<std::string> securities_;
+    std::vector<int64_t> prices_;
+    mutable_::Packet packet_;               // Generate 使用
+    mutable_::OrderSnapshot_300192 order_;
+    mutable_::TransactionSnapshot_300191 trade_;
+    mutable_::MarketSnapshot_300111 snapshot_;
+    mutable_::MarketSnapshot_309011 index_;
+};
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_SYNTHETIC_H__
@@ -0,0 +1,123 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    行情时间（LocalTimeStamp，YYYYMMDDHHMMSSsss）转换为纪元纳秒，
+//            缓存交易日零点的纪元时间，同一日内只拆分时间部分；提供整列批量转换
+
+#ifndef __CN_SZSE_BINARY_TIME_H__
+#define __CN_SZSE_BINARY_TIME_H__
+
+#include "szse_binary_type.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace cn
+{
+namespace szse
+{
+namespace binary
+{
+
+// 行情时间为北京时间，UTC+8，无夏令时
+const int32_t kBeijingUtcOffset = 8 * 3600;
+const int64_t kNanosPerSecond = 1000000000;
+const int64_t kNanosPerDay = 86400 * kNanosPerSecond;
+
+// 公历日期距 1970-01-01 的天数，适用于任意年份
+inline int64_t DaysFromCivil(int64_t year, uint32_t month, uint32_t day)
+{
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const uint32_t yoe = (uint32_t)(year - era * 400);
+    const uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+// 日期 YYYYMMDD 当日零点的纪元纳秒，utc_offset 为本地时间相对 UTC 的秒数
+inline int64_t DateEpochNanos(uint32_t date, int32_t utc_offset = kBeijingUtcOffset)
+{
+    return DaysFromCivil(date / 10000, date / 100 % 100, date % 100) * kNanosPerDay
+        - utc_offset * kNanosPerSecond;
+}
+
+// 时间戳的纪元纳秒，不使用缓存
+inline int64_t TimeStampEpochNanos(int64_t stamp, int32_t utc_offset = kBeijingUtcOffset)
+{
+    return DateEpochNanos(TimeStampDate(stamp), utc_offset) + TimeStampNanosOfDay(stamp);
+}
+
+// @Class:   TimeStampConverter
+// @Author:  cao.ning
+// @Date:    2026/10/17
+// @Brief:   带交易日缓存的时间戳转换，日期与上一条相同时只做一次 64 位常量除法
+//           及若干 32 位乘法，不涉及日历计算；跨日时重新计算零点，如夜间回放多日文件
+//           非线程安全，每个线程使用各自的对象
+class TimeStampConverter
+{
+public:
+    explicit TimeStampConverter(int32_t utc_offset = kBeijingUtcOffset)
+        : utc_offset_(utc_offset), date_(0), day_base_(DateEpochNanos(0, utc_offset)) {}
+
+    // 纪元纳秒
+    inline int64_t ToEpochNanos(int64_t stamp)
+    {
+        uint32_t date = TimeStampDate(stamp);
+        if (SZSE_BINARY_UNLIKELY(date != date_))
+        {
+            date_ = date;
+            day_base_ = DateEpochNanos(date, utc_offset_);
+        }
+        return day_base_ + TimeStampNanosOfDay(stamp);
+    }
+    // 整列转换，stamps 与 epoch_nanos 可以为同一数组
+    // 缓存放在局部变量中，避免写出结果后重新读取成员
+    void ToEpochNanos(const int64_t* stamps, size_t count, int64_t* epoch_nanos)
+    {
+        uint32_t date = date_;
+        int64_t day_base = day_base_;
+        for (size_t idx = 0; idx < count; ++idx)
+        {
+            int64_t stamp = stamps[idx];
+            uint32_t stamp_date = TimeStampDate(stamp);
+            if (SZSE_BINARY_UNLIKELY(stamp_date != date))
+            {
+                date = stamp_date;
+                day_base = DateEpochNanos(date, utc_offset_);
+            }
+            epoch_nanos[idx] = day_base + TimeStampNanosOfDay(stamp);
+        }
+        date_ = date;
+        day_base_ = day_base;
+    }
+    // 距当日零点的纳秒数，与日期无关
+    static inline int64_t ToNanosOfDay(int64_t stamp)
+    {
+        return TimeStampNanosOfDay(stamp);
+    }
+    static void ToNanosOfDay(const int64_t* stamps, size_t count, int64_t* nanos)
+    {
+        for (size_t idx = 0; idx < count; ++idx)
+        {
+            nanos[idx] = TimeStampNanosOfDay(stamps[idx]);
+        }
+    }
+
+    // 当前缓存的交易日（YYYYMMDD）及其零点的纪元纳秒
+    inline uint32_t Date() const { return date_; }
+    inline int64_t DayBase() const { return day_base_; }
+    inline int32_t UtcOffset() const { return utc_offset_; }
+
+private:
+    int32_t utc_offset_;
+    uint32_t date_;
+    int64_t day_base_;
+};
+
+
+} // namespace binary END
+} // namespace szse END
+} // namespace cn END
+
+#endif // __CN_SZSE_BINARY_TIME_H__
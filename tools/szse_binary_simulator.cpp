@@ -0,0 +1,137 @@
+﻿// @Copyright 2017, cao.ning, All Rights Reserved
+// @Author:   cao.ning
+// @Date:     2026/10/17
+// @Brief:    本地交易所行情模拟器的命令行程序，发送合成行情或回放抓包文件
+//            编译：g++ -std=c++11 -O3 -march=native -pthread -I.. szse_binary_simulator.cpp
+//            运行：./a.out [-b 地址] [-p 端口] [-r 每秒条数] [-n 条数] [-c 频道数] [-s 种子]
+//                         [-f 抓包文件] [-1]
+//                  -r 0 为不限速；-n 0 为不结束；-1 服务一个连接后退出，便于脚本中使用
+
+#include "szse_binary_simulator.hpp"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+using namespace cn::szse::binary;
+
+struct Arguments
+{
+    SimulatorOptions Options;
+    uint64_t Count;
+    uint16_t ChannelCount;
+    uint64_t Seed;
+    std::string CaptureFile;
+    bool Once;
+};
+
+bool ParseArguments(int argc, char* argv[], Arguments* args)
+{
+    args->Count = 0;
+    args->ChannelCount = 4;
+    args->Seed = 20261017;
+    args->Once = false;
+    for (int idx = 1; idx < argc; ++idx)
+    {
+        const char* flag = argv[idx];
+        if (strcmp(flag, "-1") == 0)
+        {
+            args->Once = true;
+            continue;
+        }
+        if (idx + 1 >= argc)
+        {
+            return false;
+        }
+        const char* value = argv[++idx];
+        if (strcmp(flag, "-b") == 0)
+        {
+            args->Options.BindAddress = value;
+        }
+        else if (strcmp(flag, "-p") == 0)
+        {
+            args->Options.Port = (uint16_t)atoi(value);
+        }
+        else if (strcmp(flag, "-r") == 0)
+        {
+            args->Options.MessageRate = strtoull(value, nullptr, 10);
+        }
+        else if (strcmp(flag, "-n") == 0)
+        {
+            args->Count = strtoull(value, nullptr, 10);
+        }
+        else if (strcmp(flag, "-c") == 0)
+        {
+            args->ChannelCount = (uint16_t)atoi(value);
+        }
+        else if (strcmp(flag, "-s") == 0)
+        {
+            args->Seed = strtoull(value, nullptr, 10);
+        }
+        else if (strcmp(flag, "-f") == 0)
+        {
+            args->CaptureFile = value;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Source>
+int Run(BasicExchangeSimulator<Source>& simulator, bool once)
+{
+    if (!simulator.Listen())
+    {
+        fprintf(stderr, "listen failed: %s\n", simulator.Error().c_str());
+        return 1;
+    }
+    printf("listening on port %u\n", simulator.Port());
+    fflush(stdout);
+    for (;;)
+    {
+        uint64_t sent_count = simulator.SentCount();
+        uint64_t sent_bytes = simulator.SentBytes();
+        bool result = simulator.Serve();
+        printf("session end: %s, sent %llu msgs %llu bytes, retransmit %llu requests %llu msgs\n",
+               result ? "logout" : simulator.Error().c_str(),
+               (unsigned long long)(simulator.SentCount() - sent_count),
+               (unsigned long long)(simulator.SentBytes() - sent_bytes),
+               (unsigned long long)simulator.RetransmitCount(),
+               (unsigned long long)simulator.ResentCount());
+        fflush(stdout);
+        if (once)
+        {
+            return result ? 0 : 1;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Arguments args;
+    if (!ParseArguments(argc, argv, &args))
+    {
+        fprintf(stderr, "usage: %s [-b address] [-p port] [-r rate] [-n count] "
+                "[-c channels] [-s seed] [-f capture file] [-1]\n", argv[0]);
+        return 1;
+    }
+    if (!args.CaptureFile.empty())
+    {
+        CaptureSource capture;
+        if (!capture.Open(args.CaptureFile))
+        {
+            fprintf(stderr, "can not open %s\n", args.CaptureFile.c_str());
+            return 1;
+        }
+        BasicExchangeSimulator<CaptureSource&> simulator(args.Options, capture);
+        return Run(simulator, args.Once);
+    }
+    ExchangeSimulator simulator(args.Options, args.Count, kRealisticMix,
+                                args.ChannelCount, args.Seed);
+    return Run(simulator, args.Once);
+}